@@ -1,42 +1,161 @@
+#pragma once
+
 #include <array>
+#include <cstdint>
 #include <algorithm>
 #include <memory>
 #include <vector>
-#include <map>
 
 #include "../search.cpp"
+#include "../pattern-database/distance_table.cpp"
+#include "../pattern-database/pattern_database.cpp"
 
 // ---------------------------------------------------------------------------------
 // Search algorithms: Best-First
 
-template <typename S, typename A>
-std::shared_ptr<Node<S, A>> best_first_search(Problem<S, A>& problem, ToDouble<S, A> f) {
-  std::shared_ptr<Node<S, A>> initial_node = std::make_shared<Node<S, A>>(problem.initial);
-  PriorityQueue<S, A> frontier = PriorityQueue<S, A>{ { initial_node }, f };
-  std::map<S, std::shared_ptr<Node<S, A>>> reached{
-    { problem.initial, initial_node }
-  };
+/*
+ * Best-first search: nodes with the lowest f are expanded first.
+ *
+ * P is any problem type with the members of StaticProblem (Problem<S, A> included)
+ * and f any callable from a SearchNode to its priority; both are template
+ * parameters, so nothing in the loop below goes through an indirect call unless P
+ * or F do so themselves.
+ *
+ * The context is cleared before the search, and its arena holds the whole search
+ * tree when it returns. States are kept in the reached set under the key given
+ * by the context's packer (see IdentityPacker).
+ *
+ * Each reached state has exactly one node. A cheaper path to a state still in the
+ * frontier rewrites that node and lowers its key; closed states are not reopened,
+ * so the result is optimal when f comes from a consistent heuristic. Returns the
+ * index of the goal node, or no_node if there is no path, and leaves the
+ * statistics of the search in context.stats.
+ */
+template <typename P, typename F, typename Packer>
+NodeIndex best_first_search(
+  const P& problem,
+  F f,
+  SearchContext<typename P::state_type, typename P::action_type, Packer>& context
+) {
+  using S = typename P::state_type;
+  using A = typename P::action_type;
+
+  context.clear();
+  NodeArena<S, A>& arena = context.arena;
+  IndexedHeap<>& frontier = context.frontier;
+  auto& reached = context.reached;
+  const Packer& pack = context.pack;
+  SearchStats& stats = context.stats;
+  PhaseTimer timer{ stats.phases, "search" };
+
+  NodeIndex initial_node = arena.emplace(problem.initial);
+  frontier.push(initial_node, f(arena[initial_node]));
+  reached.find_or_insert(pack(problem.initial)) = initial_node;
 
+  NodeIndex goal = no_node;  // Indicates that a path was not found.
   while (frontier) {  // Overloaded bool conversion.
-    std::shared_ptr<Node<S, A>> current_node = frontier.pop();
-    
-    if (problem.is_goal(current_node->state)) {
-      return current_node;
+    NodeIndex current_node = frontier.pop();
+    const SearchNode<S, A>& current = arena[current_node];  // Chunks never move.
+
+    if (problem.is_goal(current.state)) {
+      goal = current_node;
+      break;
     }
 
-    for (const Node<S, A>& child : expand(problem, current_node)) {
-      S s = child.state;
-      auto found_state = reached.find(s);
-      bool contains = found_state != reached.end();
+    ++stats.expanded;
+    problem.successors(current.state, [&](const A& action, const S& s, double step_cost) {
+      ++stats.generated;
+      double cost = current.path_cost + step_cost;
+      NodeIndex& found_state = reached.find_or_insert(pack(s));
 
-      if (!contains || child.path_cost < found_state->second->path_cost) {
-        reached[s] = std::make_shared<Node<S, A>>(child);
-        frontier.push(reached[s]);
+      if (found_state == no_node) {
+        found_state = arena.emplace(s, action, current_node, cost);
+        frontier.push(found_state, f(arena[found_state]));
+        return;
       }
-    }
+      ++stats.duplicates;
+      if (cost < arena[found_state].path_cost && frontier.contains(found_state)) {
+        ++stats.improved;
+        SearchNode<S, A>& child = arena[found_state];
+        child.action = action;
+        child.parent = current_node;
+        child.path_cost = cost;
+        child.depth = current.depth + 1;
+        frontier.decrease_key(found_state, f(child));
+      }
+    });
+    stats.frontier.record(frontier.len());
   }
 
-  return nullptr;  // Indicates that a path was not found.
+  stats.reached.record(reached.size());  // The reached set only grows.
+  stats.bytes.record(stats_enabled ? context.bytes() : 0);
+  return goal;
+}
+
+/*
+ * Best-first search into the given arena, which can be reused across searches.
+ * The statistics of the search are copied to *stats, if given.
+ */
+template <typename P, typename F, typename Packer = packer_of_t<P>>
+NodeIndex best_first_search(
+  const P& problem,
+  F f,
+  NodeArena<typename P::state_type, typename P::action_type>& arena,
+  Packer pack = {},
+  SearchStats* stats = nullptr
+) {
+  SearchContext<typename P::state_type, typename P::action_type, Packer> context{ pack };
+  std::swap(context.arena, arena);
+  NodeIndex goal = best_first_search(problem, f, context);
+  std::swap(context.arena, arena);
+  if (stats) {
+    *stats = context.stats;
+  }
+  return goal;
+}
+
+/*
+ * A* search: best-first search ordered by g + h.
+ */
+template <typename P>
+NodeIndex astar_search(const P& problem, NodeArena<typename P::state_type, typename P::action_type>& arena) {
+  return best_first_search(problem, AStarPriority<P>{ problem }, arena);
+}
+
+template <typename P, typename Packer>
+NodeIndex astar_search(const P& problem, SearchContext<typename P::state_type, typename P::action_type, Packer>& context) {
+  return best_first_search(problem, AStarPriority<P>{ problem }, context);
+}
+
+/*
+ * Adapter for the virtual Problem API: searches through Problem<S, A> and an
+ * ArenaToDouble, one indirect call per member.
+ */
+template <typename S, typename A, typename Packer = IdentityPacker<S>>
+NodeIndex best_first_search(
+  const Problem<S, A>& problem,
+  ArenaToDouble<S, A> f,
+  NodeArena<S, A>& arena,
+  Packer pack = {},
+  SearchStats* stats = nullptr
+) {
+  // Wrapping f in a lambda leaves this overload not viable, so the generic one is called.
+  auto priority = [&f](const SearchNode<S, A>& node) { return f(node); };
+  return best_first_search(problem, priority, arena, pack, stats);
+}
+
+template <typename S, typename A>
+std::shared_ptr<Node<S, A>> best_first_search(Problem<S, A>& problem, ToDouble<S, A> f, SearchStats* stats = nullptr) {
+  NodeArena<S, A> arena;
+  ArenaToDouble<S, A> arena_f = [&f](const SearchNode<S, A>& node) {
+    return f(Node<S, A>{ node.state, node.path_cost });
+  };
+
+  NodeIndex goal = best_first_search<S, A>(problem, arena_f, arena, IdentityPacker<S>{}, stats);
+  if (goal == no_node) {
+    return nullptr;  // Indicates that a path was not found.
+  }
+  return arena.to_node(goal);
 }
 
 
@@ -54,13 +173,53 @@ enum Actions {
   RIGHT
 };
 
+/*
+ * Packs a 3x3 board of tiles 0-8 into a 64-bit integer, one nibble per tile in
+ * row-major order: 8 bytes per key instead of 36, hashed and compared as an integer.
+ */
+template <typename S>
+struct PuzzlePacker {
+  using key_type = uint64_t;
+  using hasher = StateHash<uint64_t>;
+
+  uint64_t operator()(const S& state) const {
+    uint64_t key = 0;
+    for (int i = 0; i < 9; i++) {
+      key |= uint64_t(state[i / 3][i % 3]) << (4 * i);
+    }
+    return key;
+  }
+
+  S unpack(uint64_t key) const {
+    S state{};
+    for (int i = 0; i < 9; i++) {
+      state[i / 3][i % 3] = (key >> (4 * i)) & 0xF;
+    }
+    return state;
+  }
+};
+
 template <typename S, typename A>
-struct EightPuzzle : public Problem<S, A> {
+struct EightPuzzle final : public Problem<S, A> {
+  using packer = PuzzlePacker<S>;
+
   EightPuzzle(S initial, S goal)
     : Problem<S, A>(initial, goal) {
     setIndexes();
   }
 
+  /*
+   * Reuses this puzzle for another instance. The goal indexes are only rebuilt
+   * when the goal changes.
+   */
+  void reset(const S& initial, const S& goal) {
+    this->initial = initial;
+    if (!(goal == this->goal)) {
+      this->goal = goal;
+      setIndexes();
+    }
+  }
+
   void setIndexes() {
     Index index;
     int i = 0;
@@ -113,22 +272,62 @@ struct EightPuzzle : public Problem<S, A> {
   }
 
   std::vector<A> actions(const S state) const override {
-    std::vector<A> possible_actions = { UP, DOWN, LEFT, RIGHT };
-    Index indexes = find_blank_square(state);
+    std::vector<A> possible_actions;
+    possible_actions.reserve(4);
+    for_each_action(find_blank_square(state), [&](A action) {
+      possible_actions.push_back(action);
+    });
+    return possible_actions;
+  }
 
-    if (indexes.row == 0) {
-      possible_actions.erase(std::remove(possible_actions.begin(), possible_actions.end(), UP), possible_actions.end());
-    }
-    if (indexes.row == 2) {
-      possible_actions.erase(std::remove(possible_actions.begin(), possible_actions.end(), DOWN), possible_actions.end());
-    }
-    if (indexes.col == 0) {
-      possible_actions.erase(std::remove(possible_actions.begin(), possible_actions.end(), LEFT), possible_actions.end());
-    }
-    if (indexes.col == 2) {
-      possible_actions.erase(std::remove(possible_actions.begin(), possible_actions.end(), RIGHT), possible_actions.end());
+  size_t actions_into(const S& state, A* out, size_t capacity) const override {
+    size_t count = 0;
+    for_each_action(find_blank_square(state), [&](A action) {
+      if (count < capacity) {
+        out[count] = action;
+      }
+      count++;
+    });
+    return count;
+  }
+
+  /*
+   * Generates every successor without allocating: the blank is looked up once
+   * and each child is built on the stack by sliding one tile.
+   */
+  template <typename Visitor>
+  void successors(const S& state, Visitor&& visit) const {
+    Index blank = find_blank_square(state);
+    for_each_action(blank, [&](A action) {
+      Index tile = moved_tile(blank, action);
+      S new_state = state;
+      new_state[blank.row][blank.col] = state[tile.row][tile.col];
+      new_state[tile.row][tile.col] = 0;
+      visit(action, new_state, 1.0);
+    });
+  }
+
+  /*
+   * Calls visit with every action allowed with the blank at the given position.
+   */
+  template <typename Visitor>
+  static void for_each_action(Index blank, Visitor&& visit) {
+    if (blank.row > 0) visit(UP);
+    if (blank.row < 2) visit(DOWN);
+    if (blank.col > 0) visit(LEFT);
+    if (blank.col < 2) visit(RIGHT);
+  }
+
+  /*
+   * Position of the tile that action slides into the blank.
+   */
+  static Index moved_tile(Index blank, A action) {
+    switch (action) {
+      case UP:    return { blank.row - 1, blank.col };
+      case DOWN:  return { blank.row + 1, blank.col };
+      case LEFT:  return { blank.row, blank.col - 1 };
+      default:    return { blank.row, blank.col + 1 };
     }
-    return possible_actions;
   }
 
   int updateRow(int& i, int j) const {
@@ -139,19 +338,30 @@ struct EightPuzzle : public Problem<S, A> {
     return i;
   };
 
-  bool check_solvability(S state) {
-    int i = 0;
-    int inversions = 0;
-    for (int j = 0 ; j < 8; j++) {
-      auto current = state[i][j%3];
-      auto next = state[updateRow(i, j)][(j+1)%3];
+  /*
+   * On a board of odd width a move never changes the parity of the number of
+   * inversions, so a state can reach the goal iff both parities agree.
+   */
+  bool check_solvability(S state) const {
+    return inversions(state) % 2 == inversions(this->goal) % 2;
+  }
 
-      if (current > next and current != 0 and next != 0) {
-        inversions++;
+  /*
+   * Number of pairs of tiles (the blank excluded) out of order, reading the board
+   * in row-major order.
+   */
+  static int inversions(const S& state) {
+    int count = 0;
+    for (int i = 0; i < 9; i++) {
+      for (int j = i + 1; j < 9; j++) {
+        int current = state[i / 3][i % 3];
+        int next = state[j / 3][j % 3];
+        if (current > next && current != 0 && next != 0) {
+          count++;
+        }
       }
     }
-
-    return inversions % 2 == 0;
+    return count;
   }
 
   double action_cost(const S state_1, const A action, const S state_2) const override {
@@ -163,20 +373,34 @@ struct EightPuzzle : public Problem<S, A> {
   }
 
   double h(Node<S, A> node) const override {
+    return h(node.state);
+  }
+
+  /*
+   * Sum of the Manhattan distances of the tiles to their goal positions, or the
+   * exact distance when a distance table is set, or the pattern database
+   * estimate when one is set.
+   */
+  double h(const S& state) const override {
+    if (distance_table || pattern_database) {
+      int board[9];
+      for (int i = 0; i < 9; i++) {
+        board[i] = state[i / 3][i % 3];
+      }
+      return distance_table ? distance_table->h(board) : pattern_database->h(board);
+    }
+
     int heuristic_value = 0;
-    Index index;
-    
     for (int i = 0 ; i < 3 ; i++) {
       for (int j = 0 ; j < 3 ; j++) {
-        auto current = node.state[i][j];
-        auto it = indexes.find(current);
-        if(it != indexes.end()) {
-          index = it->second;
+        auto current = state[i][j];
+        if (current != 0) {
+          const Index& index = indexes[current];
           heuristic_value += abs(index.row - i) + abs(index.col - j);
         }
       }
     }
-    return -heuristic_value;
+    return heuristic_value;
   }
 
   Index find_blank_square(S state) const {
@@ -196,5 +420,37 @@ struct EightPuzzle : public Problem<S, A> {
     return zeroIndex;
   }
 
-  std::map<int, Index> indexes;
+  std::array<Index, 9> indexes;  // Goal position of each tile.
+  const PatternDatabase* pattern_database = nullptr;
+  const DistanceTable* distance_table = nullptr;  // Built for goal.
 };
+
+/*
+ * Optimal solution of an 8 Puzzle without searching: greedy descent through a
+ * distance table built for the puzzle's goal, in O(depth). Throws
+ * invalid_argument if the table has another goal, or the initial state cannot
+ * reach the goal.
+ */
+template <typename S, typename A>
+std::vector<A> table_solution(const EightPuzzle<S, A>& puzzle, const DistanceTable& table) {
+  int board[9];
+  for (int i = 0; i < 9; i++) {
+    if (table.width != 3 || table.height != 3 || table.goal[i] != puzzle.goal[i / 3][i % 3]) {
+      throw std::invalid_argument{ "Distance table was built for another goal" };
+    }
+    board[i] = puzzle.initial[i / 3][i % 3];
+  }
+
+  std::vector<A> actions;
+  int blank = std::find(board, board + 9, 0) - board;
+  for (int cell : table.solve(board)) {
+    switch (cell - blank) {
+      case -3: actions.push_back(UP); break;
+      case 3:  actions.push_back(DOWN); break;
+      case -1: actions.push_back(LEFT); break;
+      default: actions.push_back(RIGHT); break;
+    }
+    blank = cell;
+  }
+  return actions;
+}
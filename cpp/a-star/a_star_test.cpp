@@ -2,6 +2,9 @@
 #include "../catch.hpp"
 
 #include "a_star.cpp"
+#include "batch_search.cpp"
+
+#include <set>
 
 TEST_CASE("A* can solve valid 8 Puzzle") {
   using namespace std::placeholders;
@@ -30,4 +33,418 @@ TEST_CASE("A* can't solve invalid 8 Puzzle") {
     {4, 6, 5},  // Troque a posição de 5 e 6 para tornar a matriz insolucionável
     {7, 8, 0}
   }};
+
+  Matrix goal = {{
+    {1, 2, 3},
+    {4, 5, 6},
+    {7, 8, 0}
+  }};
+
+  EightPuzzle<Matrix, Actions> eightPuzzle(fake, goal);
+  REQUIRE(!eightPuzzle.check_solvability(fake));
+  REQUIRE(eightPuzzle.check_solvability(goal));
+  REQUIRE(eightPuzzle.check_solvability(Matrix{{ {7, 2, 4}, {5, 0, 6}, {8, 3, 1} }}));
+}
+
+TEST_CASE("A* can reuse a node arena") {
+  Matrix initial = {{
+    {1, 2, 5},
+    {3, 4, 0},
+    {6, 7, 8}
+  }};
+
+  Matrix goal = {{
+    {0, 1, 2},
+    {3, 4, 5},
+    {6, 7, 8}
+  }};
+
+  EightPuzzle<Matrix, Actions> eightPuzzle(initial, goal);
+  ArenaToDouble<Matrix, Actions> f = [](const SearchNode<Matrix, Actions>& node) {
+    return node.path_cost;
+  };
+  NodeArena<Matrix, Actions> arena;
+
+  for (int run = 0; run < 2; run++) {
+    NodeIndex found = best_first_search<Matrix, Actions>(eightPuzzle, f, arena);
+    REQUIRE(found != no_node);
+
+    std::vector<Matrix> states = arena.path_states(found);
+    std::vector<Actions> actions = arena.path_actions(found);
+    REQUIRE(states.front() == initial);
+    REQUIRE(states.back() == goal);
+    REQUIRE(actions.size() == 3);
+    REQUIRE(arena[found].depth == 3);
+    REQUIRE(arena.to_node(found)->path_cost == Approx(3));
+  }
+}
+
+TEST_CASE("8 Puzzle states pack into 64 bits") {
+  Matrix state = {{
+    {7, 2, 4},
+    {5, 0, 6},
+    {8, 3, 1}
+  }};
+  PuzzlePacker<Matrix> pack;
+
+  REQUIRE(pack.unpack(pack(state)) == state);
+  REQUIRE(pack(state) != pack(Matrix{{ {2, 7, 4}, {5, 0, 6}, {8, 3, 1} }}));
+}
+
+TEST_CASE("A* finds the same path cost with packed states") {
+  Matrix initial = {{
+    {7, 2, 4},
+    {5, 0, 6},
+    {8, 3, 1}
+  }};
+
+  Matrix goal = {{
+    {0, 1, 2},
+    {3, 4, 5},
+    {6, 7, 8}
+  }};
+
+  EightPuzzle<Matrix, Actions> eightPuzzle(initial, goal);
+  ArenaToDouble<Matrix, Actions> f = [](const SearchNode<Matrix, Actions>& node) {
+    return node.path_cost;
+  };
+  NodeArena<Matrix, Actions> arena;
+
+  NodeIndex plain = best_first_search<Matrix, Actions>(eightPuzzle, f, arena);
+  double plain_cost = arena[plain].path_cost;
+  NodeIndex packed = best_first_search<Matrix, Actions>(eightPuzzle, f, arena, PuzzlePacker<Matrix>{});
+
+  REQUIRE(packed != no_node);
+  REQUIRE(arena[packed].path_cost == Approx(plain_cost));
+  REQUIRE(eightPuzzle.is_goal(arena[packed].state));
+}
+
+TEST_CASE("Indexed heap pops by key and updates keys in place") {
+  IndexedHeap<> heap;
+  heap.push(0, 5.0);
+  heap.push(1, 3.0);
+  heap.push(2, 8.0);
+  heap.push(3, 1.0);
+  heap.push(4, 7.0);
+  heap.push(5, 6.0);
+
+  heap.decrease_key(2, 2.0);
+  REQUIRE(heap.len() == 6);
+  REQUIRE(heap.contains(2));
+
+  std::vector<NodeIndex> order;
+  while (heap) {
+    order.push_back(heap.pop());
+  }
+  REQUIRE(order == std::vector<NodeIndex>{ 3, 2, 1, 0, 5, 4 });
+  REQUIRE(!heap.contains(2));
+}
+
+TEST_CASE("A* keeps one node per reached state") {
+  Matrix initial = {{
+    {7, 2, 4},
+    {5, 0, 6},
+    {8, 3, 1}
+  }};
+
+  Matrix goal = {{
+    {0, 1, 2},
+    {3, 4, 5},
+    {6, 7, 8}
+  }};
+
+  EightPuzzle<Matrix, Actions> eightPuzzle(initial, goal);
+  ArenaToDouble<Matrix, Actions> f = [](const SearchNode<Matrix, Actions>& node) {
+    return node.path_cost;
+  };
+  NodeArena<Matrix, Actions> arena;
+  PuzzlePacker<Matrix> pack;
+
+  NodeIndex found = best_first_search<Matrix, Actions>(eightPuzzle, f, arena, pack);
+  REQUIRE(found != no_node);
+
+  std::set<uint64_t> states;
+  for (NodeIndex i = 0; i < arena.size(); i++) {
+    states.insert(pack(arena[i].state));
+  }
+  REQUIRE(states.size() == arena.size());
+}
+
+/*
+ * Walk on the integer line, one step at a time, towards the goal.
+ */
+struct LineWalk : StaticProblem<LineWalk, int, int> {
+  LineWalk(int initial, int goal) : StaticProblem<LineWalk, int, int>{ initial, goal } {}
+
+  std::vector<int> actions(int /* state */) const {
+    return { -1, 1 };
+  }
+
+  int result(int state, int action) const {
+    return state + action;
+  }
+
+  double h(int state) const {
+    return std::abs(goal - state);
+  }
+};
+
+TEST_CASE("A* runs on statically dispatched problems") {
+  LineWalk walk{ 3, -4 };
+  NodeArena<int, int> arena;
+
+  NodeIndex found = astar_search(walk, arena);
+  REQUIRE(found != no_node);
+  REQUIRE(arena[found].state == -4);
+  REQUIRE(arena[found].path_cost == Approx(7));
+  REQUIRE(arena.size() < 20);  // The heuristic is exact, nothing off the path is expanded.
+}
+
+TEST_CASE("A* accepts a problem subclass directly") {
+  Matrix initial = {{
+    {1, 2, 5},
+    {3, 4, 0},
+    {6, 7, 8}
+  }};
+
+  Matrix goal = {{
+    {0, 1, 2},
+    {3, 4, 5},
+    {6, 7, 8}
+  }};
+
+  EightPuzzle<Matrix, Actions> eightPuzzle(initial, goal);
+  NodeArena<Matrix, Actions> arena;
+  auto uniform_cost = [](const SearchNode<Matrix, Actions>& node) { return node.path_cost; };
+
+  NodeIndex found = best_first_search(eightPuzzle, uniform_cost, arena);
+  REQUIRE(found != no_node);
+  REQUIRE(arena[found].path_cost == Approx(3));
+}
+
+TEST_CASE("8 Puzzle successors match actions and result") {
+  Matrix state = {{
+    {7, 2, 4},
+    {5, 0, 6},
+    {8, 3, 1}
+  }};
+  Matrix corner = {{
+    {0, 2, 4},
+    {5, 7, 6},
+    {8, 3, 1}
+  }};
+  EightPuzzle<Matrix, Actions> eightPuzzle(state, state);
+
+  for (const Matrix& s : { state, corner }) {
+    std::vector<Actions> actions;
+    eightPuzzle.successors(s, [&](Actions action, const Matrix& child, double cost) {
+      REQUIRE(child == eightPuzzle.result(s, action));
+      REQUIRE(cost == Approx(1));
+      actions.push_back(action);
+    });
+    REQUIRE(actions == eightPuzzle.actions(s));
+
+    // Through the virtual API, the actions come from actions_into.
+    const Problem<Matrix, Actions>& problem = eightPuzzle;
+    std::vector<Actions> virtual_actions;
+    problem.successors(s, [&](Actions action, const Matrix& child, double /* cost */) {
+      REQUIRE(child == eightPuzzle.result(s, action));
+      virtual_actions.push_back(action);
+    });
+    REQUIRE(virtual_actions == actions);
+    Actions buffer[1];
+    REQUIRE(problem.actions_into(s, buffer, 1) == actions.size());
+  }
+  REQUIRE(eightPuzzle.actions(corner).size() == 2);
+}
+
+TEST_CASE("A* with a pattern database finds optimal paths") {
+  Matrix initial = {{
+    {8, 6, 7},
+    {2, 5, 4},
+    {3, 0, 1}
+  }};
+
+  Matrix goal = {{
+    {1, 2, 3},
+    {4, 5, 6},
+    {7, 8, 0}
+  }};
+
+  EightPuzzle<Matrix, Actions> eightPuzzle(initial, goal);
+  NodeArena<Matrix, Actions> arena;
+
+  NodeIndex manhattan = astar_search(eightPuzzle, arena);
+  REQUIRE(manhattan != no_node);
+  double optimal = arena[manhattan].path_cost;
+  size_t manhattan_nodes = arena.size();
+
+  PatternDatabase database{ 3, 3, { 1, 2, 3, 4, 5, 6, 7, 8, 0 }, { { 1, 2, 3, 4 }, { 5, 6, 7, 8 } } };
+  eightPuzzle.pattern_database = &database;
+  NodeIndex pattern = astar_search(eightPuzzle, arena);
+
+  REQUIRE(optimal == Approx(31));  // One of the two hardest 8 Puzzle instances.
+  REQUIRE(arena[pattern].path_cost == Approx(optimal));
+  REQUIRE(arena.size() < manhattan_nodes);
+}
+
+TEST_CASE("A distance table solves 8 Puzzles without searching") {
+  Matrix goal = {{
+    {1, 2, 3},
+    {4, 5, 6},
+    {7, 8, 0}
+  }};
+  DistanceTable table{ 3, 3, { 1, 2, 3, 4, 5, 6, 7, 8, 0 } };
+  EightPuzzle<Matrix, Actions> eightPuzzle(goal, goal);
+
+  srand(23);
+  for (int i = 0; i < 30; i++) {
+    Matrix state = goal;
+    for (int step = 0; step < 40; step++) {
+      std::vector<Actions> actions = eightPuzzle.actions(state);
+      state = eightPuzzle.result(state, actions[rand() % actions.size()]);
+    }
+    eightPuzzle.reset(state, goal);
+
+    NodeArena<Matrix, Actions> arena;
+    eightPuzzle.distance_table = nullptr;
+    NodeIndex optimal = astar_search(eightPuzzle, arena);
+    std::vector<Actions> solution = table_solution(eightPuzzle, table);
+    REQUIRE(solution.size() == arena[optimal].path_cost);
+    for (Actions action : solution) {
+      state = eightPuzzle.result(state, action);
+    }
+    REQUIRE(state == goal);
+
+    // With the exact distance as h, A* only expands the solution path.
+    eightPuzzle.distance_table = &table;
+    NodeIndex exact = astar_search(eightPuzzle, arena);
+    REQUIRE(arena[exact].path_cost == solution.size());
+    REQUIRE(arena.size() <= 4 * solution.size() + 1);
+  }
+
+  DistanceTable other{ 3, 3, { 0, 1, 2, 3, 4, 5, 6, 7, 8 } };
+  REQUIRE_THROWS_AS(table_solution(eightPuzzle, other), std::invalid_argument);
+}
+
+TEST_CASE("Thread pool runs every task") {
+  ThreadPool pool{ 4 };
+  std::vector<int> seen(1000, 0);
+  std::vector<int> worker(1000, -1);
+
+  pool.parallel_for(0, seen.size(), [&](size_t i) {
+    worker[i] = ThreadPool::worker_index();
+    seen[i]++;
+  }, 7);
+  REQUIRE(std::count(seen.begin(), seen.end(), 1) == 1000);
+  REQUIRE(*std::min_element(worker.begin(), worker.end()) >= 0);
+
+  std::atomic<int> nested{ 0 };
+  for (int i = 0; i < 10; i++) {
+    pool.submit([&] {
+      for (int j = 0; j < 10; j++) {
+        pool.submit([&] { nested++; });
+      }
+    });
+  }
+  pool.wait();
+  REQUIRE(nested == 100);
+  REQUIRE(ThreadPool::worker_index() == -1);
+}
+
+TEST_CASE("Batches of 8 Puzzles are solved in input order") {
+  Matrix goal = {{
+    {0, 1, 2},
+    {3, 4, 5},
+    {6, 7, 8}
+  }};
+  EightPuzzle<Matrix, Actions> walker(goal, goal);
+
+  srand(17);
+  std::vector<std::pair<Matrix, Matrix>> instances;
+  for (int i = 0; i < 40; i++) {
+    Matrix state = goal;
+    for (int step = 0; step < 10 + i; step++) {
+      std::vector<Actions> actions = walker.actions(state);
+      state = walker.result(state, actions[rand() % actions.size()]);
+    }
+    instances.push_back({ state, goal });
+  }
+  instances.push_back({ Matrix{{ {1, 0, 2}, {3, 4, 5}, {6, 8, 7} }}, goal });  // Unsolvable.
+
+  ThreadPool pool{ 3 };
+  auto solutions = solve_batch<Matrix, Actions>(instances, pool);
+  REQUIRE(solutions.size() == instances.size());
+
+  for (size_t i = 0; i + 1 < instances.size(); i++) {
+    EightPuzzle<Matrix, Actions> puzzle(instances[i].first, goal);
+    NodeArena<Matrix, Actions> arena;
+    NodeIndex optimal = astar_search(puzzle, arena);
+
+    REQUIRE(solutions[i].found);
+    REQUIRE(solutions[i].cost == Approx(arena[optimal].path_cost));
+    Matrix state = instances[i].first;
+    for (Actions action : solutions[i].actions) {
+      state = puzzle.result(state, action);
+    }
+    REQUIRE(state == goal);
+  }
+  REQUIRE(!solutions.back().found);
+}
+
+TEST_CASE("Best-first search fills in its statistics") {
+  Matrix initial = {{
+    {7, 2, 4},
+    {5, 0, 6},
+    {8, 3, 1}
+  }};
+  Matrix goal = {{
+    {0, 1, 2},
+    {3, 4, 5},
+    {6, 7, 8}
+  }};
+  EightPuzzle<Matrix, Actions> eightPuzzle(initial, goal);
+  SearchContext<Matrix, Actions, PuzzlePacker<Matrix>> context;
+  NodeIndex found = astar_search(eightPuzzle, context);
+  REQUIRE(found != no_node);
+
+  const SearchStats& stats = context.stats;
+  if (stats_enabled) {
+    REQUIRE(stats.expanded.value() > 0);
+    REQUIRE(stats.generated.value() >= stats.expanded.value());
+    // Every generated state is either new, with a node of its own, or a duplicate.
+    REQUIRE(stats.generated.value() - stats.duplicates.value() == context.arena.size() - 1);
+    REQUIRE(stats.improved.value() <= stats.duplicates.value());
+    REQUIRE(stats.reached.value() == context.arena.size());
+    REQUIRE(stats.frontier.value() > 0);
+    REQUIRE(stats.frontier.value() <= context.arena.size());
+    REQUIRE(stats.bytes.value() >= context.arena.size() * sizeof(SearchNode<Matrix, Actions>));
+    REQUIRE(stats.phases["search"] > 0);
+  }
+
+  std::string json = to_json(stats);
+  REQUIRE(json.front() == '{');
+  REQUIRE(json.back() == '}');
+  REQUIRE(json.find("\"expanded\":" + std::to_string(stats.expanded.value())) != std::string::npos);
+  REQUIRE(json.find("\"phases\":{") != std::string::npos);
+
+  // The next search starts from zero.
+  astar_search(eightPuzzle, context);
+  REQUIRE(context.stats.generated.value() == stats.generated.value());
+
+  SearchStats copied;
+  NodeArena<Matrix, Actions> arena;
+  best_first_search(eightPuzzle, AStarPriority<EightPuzzle<Matrix, Actions>>{ eightPuzzle }, arena, PuzzlePacker<Matrix>{}, &copied);
+  REQUIRE(copied.expanded.value() == stats.expanded.value());
+}
+
+TEST_CASE("JSON objects escape strings and nest") {
+  std::ostringstream out;
+  {
+    JsonObject json{ out };
+    json.field("name", "a \"b\"\n").field("count", uint64_t(3)).field("nan", std::nan(""));
+    JsonObject inner{ json.key("inner") };
+    inner.field("ok", true);
+  }
+  REQUIRE(out.str() == "{\"name\":\"a \\\"b\\\"\\u000a\",\"count\":3,\"nan\":null,\"inner\":{\"ok\":true}}");
 }
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "a_star.cpp"
+#include "../concurrency.cpp"
+
+// ---------------------------------------------------------------------------------
+// Batch solving
+
+/*
+ * Outcome of one instance of a batch.
+ */
+template <typename A>
+struct BatchSolution {
+  bool found = false;
+  double cost = 0;
+  std::vector<A> actions;  // From the initial state to the goal.
+  size_t nodes = 0;        // Size of the search tree.
+};
+
+/*
+ * Solves every (initial, goal) pair of instances with A* on the pool, and
+ * returns the solutions in the order of the instances.
+ *
+ * Each pool thread keeps one puzzle and one search context (arena, reached set
+ * and frontier, keyed by packed boards) for the whole batch, so after its first
+ * few instances a thread solves the next ones without allocating, and without
+ * rebuilding the goal indexes while the goal stays the same.
+ */
+template <typename S, typename A>
+std::vector<BatchSolution<A>> solve_batch(const std::vector<std::pair<S, S>>& instances, ThreadPool& pool) {
+  struct Scratch {
+    std::unique_ptr<EightPuzzle<S, A>> puzzle;
+    SearchContext<S, A, PuzzlePacker<S>> context;
+  };
+
+  std::vector<Scratch> scratch(pool.size());
+  std::vector<BatchSolution<A>> solutions(instances.size());
+
+  pool.parallel_for(0, instances.size(), [&](size_t i) {
+    Scratch& own = scratch[ThreadPool::worker_index()];
+    const auto& [initial, goal] = instances[i];
+    if (!own.puzzle) {
+      own.puzzle = std::make_unique<EightPuzzle<S, A>>(initial, goal);
+    } else {
+      own.puzzle->reset(initial, goal);
+    }
+
+    NodeIndex found = astar_search(*own.puzzle, own.context);
+    BatchSolution<A>& solution = solutions[i];
+    solution.nodes = own.context.arena.size();
+    if (found != no_node) {
+      solution.found = true;
+      solution.cost = own.context.arena[found].path_cost;
+      solution.actions = own.context.arena.path_actions(found);
+    }
+  });
+
+  return solutions;
+}
@@ -0,0 +1,419 @@
+#include <sys/resource.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "generators.cpp"
+#include "../stats.cpp"
+#include "../a-star/batch_search.cpp"
+#include "../ida-star/ida_star.cpp"
+#include "../hda-star/hda_star.cpp"
+#include "../genetic/genetic.cpp"
+#include "../simulated-annealing/simulated_annealing.cpp"
+#include "../mcts/parallel_mcts.cpp"
+
+/*
+ * Benchmark suite of the C++ algorithms, on instances generated from a seed.
+ * Prints one JSON object per line (JSON Lines), so runs of two releases can be
+ * compared by a script:
+ *
+ *   {"benchmark":"astar","problem":"8-puzzle","threads":1,"runs":1000,"seconds":...,
+ *    "throughput":...,"unit":"nodes/s","latency_us":{"p50":...,"p90":...,"p99":...,"max":...},
+ *    "peak_rss_kb":...}
+ *
+ * Single-thread benchmarks time every run, for the latency percentiles; scaling
+ * benchmarks repeat a fixed amount of work on 1, 2, 4... threads and report the
+ * throughput and the speedup over one thread. peak_rss_kb is the peak resident
+ * set of the process so far (it never goes down), so run one benchmark with
+ * --filter to measure its own.
+ *
+ *   g++ -std=c++17 -O2 -pthread benchmark.cpp -o benchmark
+ *   ./benchmark [--quick] [--seed N] [--threads N] [--filter NAME]
+ */
+
+struct Options {
+  uint64_t seed = 1;
+  bool quick = false;
+  size_t threads = std::max(1u, std::thread::hardware_concurrency());  // Most threads of the scaling runs.
+  std::string filter;
+};
+
+using Clock = std::chrono::steady_clock;
+
+double seconds_since(Clock::time_point start) {
+  return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+long peak_rss_kb() {
+  rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_maxrss;  // Kilobytes on Linux.
+}
+
+/*
+ * Durations of the runs of a benchmark.
+ */
+struct Latencies {
+  void add(double seconds) {
+    runs.push_back(seconds);
+  }
+
+  double total() const {
+    double sum = 0;
+    for (double seconds : runs) sum += seconds;
+    return sum;
+  }
+
+  /*
+   * Nearest-rank percentile, in microseconds.
+   */
+  double percentile(double p) {
+    std::sort(runs.begin(), runs.end());
+    size_t rank = std::max<size_t>(1, size_t(std::ceil(p / 100 * runs.size())));
+    return runs[std::min(rank, runs.size()) - 1] * 1e6;
+  }
+
+  std::vector<double> runs;
+};
+
+/*
+ * Prints the line of a benchmark. extra adds fields of its own.
+ */
+void report(
+  const char* benchmark,
+  const std::string& problem,
+  size_t threads,
+  size_t runs,
+  double seconds,
+  double work,
+  const char* unit,
+  Latencies* latencies = nullptr,
+  std::function<void(JsonObject&)> extra = {}
+) {
+  {
+    JsonObject json{ std::cout };
+    json.field("benchmark", benchmark)
+      .field("problem", problem)
+      .field("threads", uint64_t(threads))
+      .field("runs", uint64_t(runs))
+      .field("seconds", seconds)
+      .field("throughput", seconds > 0 ? work / seconds : 0.0)
+      .field("unit", unit);
+    if (latencies && !latencies->runs.empty()) {
+      JsonObject latency{ json.key("latency_us") };
+      latency.field("p50", latencies->percentile(50))
+        .field("p90", latencies->percentile(90))
+        .field("p99", latencies->percentile(99))
+        .field("max", latencies->percentile(100));
+    }
+    if (extra) {
+      extra(json);
+    }
+    json.field("peak_rss_kb", uint64_t(peak_rss_kb()));
+  }
+  std::cout << std::endl;
+}
+
+/*
+ * 1, 2, 4... up to most, and most itself.
+ */
+std::vector<size_t> thread_counts(size_t most) {
+  std::vector<size_t> counts;
+  for (size_t threads = 1; threads < most; threads *= 2) {
+    counts.push_back(threads);
+  }
+  counts.push_back(most);
+  return counts;
+}
+
+/*
+ * Runs work(threads) for every thread count, and reports its throughput (work
+ * returns the amount done) with the speedup over one thread.
+ */
+void scaling(const char* benchmark, const std::string& problem, const char* unit, const Options& options,
+             const std::function<double(size_t)>& work) {
+  double single = 0;
+  for (size_t threads : thread_counts(options.threads)) {
+    auto start = Clock::now();
+    double done = work(threads);
+    double seconds = seconds_since(start);
+    double throughput = seconds > 0 ? done / seconds : 0;
+    if (threads == 1) single = throughput;
+    report(benchmark, problem, threads, 1, seconds, done, unit, nullptr, [&](JsonObject& json) {
+      json.field("speedup", single > 0 ? throughput / single : 0.0);
+    });
+  }
+}
+
+// ---------------------------------------------------------------------------------
+// Search
+
+template <int W, int H>
+void astar_benchmark(const std::string& problem, const std::vector<std::array<int, W * H>>& boards) {
+  using Puzzle = SlidingTile<W, H>;
+  Puzzle puzzle{ boards[0], tile_goal<W, H>() };
+  SearchContext<typename Puzzle::State, Actions, TilePacker<W, H>> context;
+
+  Latencies latencies;
+  double nodes = 0, expanded = 0;
+  for (const auto& board : boards) {
+    puzzle.initial = puzzle.make_state(board);
+    auto start = Clock::now();
+    NodeIndex goal = astar_search(puzzle, context);
+    latencies.add(seconds_since(start));
+    if (goal == no_node) {
+      std::cerr << problem << ": an instance has no solution\n";
+      std::exit(1);
+    }
+    nodes += context.arena.size();
+    expanded += context.stats.expanded.value();
+  }
+  report("astar", problem, 1, boards.size(), latencies.total(), nodes, "nodes/s", &latencies, [&](JsonObject& json) {
+    json.field("expanded", uint64_t(expanded));
+    json.field("bytes", context.stats.bytes);
+  });
+}
+
+template <int W, int H>
+void ida_star_benchmark(const std::string& problem, const std::vector<std::array<int, W * H>>& boards) {
+  Latencies latencies;
+  double nodes = 0;
+  for (const auto& board : boards) {
+    SlidingTile<W, H> puzzle{ board, tile_goal<W, H>() };
+    auto start = Clock::now();
+    auto result = ida_star_search(puzzle);
+    latencies.add(seconds_since(start));
+    nodes += result.nodes;
+  }
+  report("ida_star", problem, 1, boards.size(), latencies.total(), nodes, "nodes/s", &latencies);
+}
+
+void search_benchmarks(const Options& options, const std::function<bool(const char*)>& selected) {
+  Random random{ options.seed };
+  std::vector<std::array<int, 9>> eight(options.quick ? 100 : 1000);
+  for (auto& board : eight) board = random_tile_board<3, 3>(random);
+  std::vector<std::array<int, 16>> fifteen(options.quick ? 10 : 50);
+  for (auto& board : fifteen) board = random_walk_tile_board<4, 4>(random, options.quick ? 30 : 45);
+
+  if (selected("astar")) {
+    astar_benchmark<3, 3>("8-puzzle", eight);
+    astar_benchmark<4, 4>("15-puzzle", fifteen);
+  }
+  if (selected("ida_star")) {
+    ida_star_benchmark<3, 3>("8-puzzle", eight);
+    ida_star_benchmark<4, 4>("15-puzzle", fifteen);
+  }
+
+  if (selected("distance_table")) {
+    auto start = Clock::now();
+    std::array<int, 9> goal = tile_goal<3, 3>();
+    DistanceTable table{ 3, 3, std::vector<int>(goal.begin(), goal.end()) };
+    double build = seconds_since(start);
+
+    Latencies latencies;
+    double moves = 0;
+    for (const auto& board : eight) {
+      auto solve_start = Clock::now();
+      moves += table.solve(board).size();
+      latencies.add(seconds_since(solve_start));
+    }
+    report("distance_table", "8-puzzle", 1, eight.size(), latencies.total(), moves, "moves/s", &latencies, [&](JsonObject& json) {
+      json.field("build_seconds", build);
+      json.field("bytes", uint64_t(table.size_bytes()));
+    });
+  }
+
+  if (selected("batch_astar")) {
+    std::vector<std::pair<Matrix, Matrix>> instances;
+    Matrix goal;
+    for (int cell = 0; cell < 9; cell++) goal[cell / 3][cell % 3] = cell;
+    for (const auto& board : eight) {
+      Matrix initial;
+      for (int cell = 0; cell < 9; cell++) initial[cell / 3][cell % 3] = board[cell];
+      instances.push_back({ initial, goal });
+    }
+    scaling("batch_astar", "8-puzzle", "instances/s", options, [&](size_t threads) {
+      ThreadPool pool{ threads };
+      solve_batch<Matrix, Actions>(instances, pool);
+      return double(instances.size());
+    });
+  }
+
+  if (selected("hda_star")) {
+    std::vector<std::array<int, 16>> hard(options.quick ? 2 : 5);
+    for (auto& board : hard) board = random_walk_tile_board<4, 4>(random, options.quick ? 40 : 60);
+    scaling("hda_star", "15-puzzle", "nodes/s", options, [&](size_t threads) {
+      double nodes = 0;
+      for (const auto& board : hard) {
+        SlidingTile<4, 4> puzzle{ board, tile_goal<4, 4>() };
+        nodes += hda_star_search(puzzle, threads).expanded();
+      }
+      return nodes;
+    });
+  }
+}
+
+// ---------------------------------------------------------------------------------
+// Genetic algorithm
+
+void genetic_benchmarks(const Options& options, const std::function<bool(const char*)>& selected) {
+  Random random{ options.seed };
+  using Board = std::vector<int>;
+
+  if (selected("genetic")) {
+    for (int n : { 8, 16, 32 }) {
+      Board gene_pool(n);
+      for (int i = 0; i < n; i++) gene_pool[i] = i;
+      Termination termination;
+      termination.max_generations = options.quick ? 200 : 1000;
+
+      Latencies latencies;
+      double generations = 0;
+      uint64_t solved = 0;
+      int runs = options.quick ? 3 : 10;
+      for (int run = 0; run < runs; run++) {
+        auto population = random_queens_population(100, n, random);
+        QueensFitness fitness;
+        AliasSelection selection;
+        auto start = Clock::now();
+        GAResult<Board> result = evolve<Board>(population, fitness, 0.1, gene_pool, 2, selection, termination, random);
+        latencies.add(seconds_since(start));
+        generations += result.generations;
+        solved += result.solved();
+      }
+      report("genetic", std::to_string(n) + "-queens", 1, runs, latencies.total(), generations, "generations/s", &latencies,
+             [&](JsonObject& json) { json.field("solved", solved); });
+    }
+  }
+
+  if (selected("parallel_genetic")) {
+    int n = 64;
+    Board gene_pool(n);
+    for (int i = 0; i < n; i++) gene_pool[i] = i;
+    auto population = random_queens_population(options.quick ? 200 : 800, n, random);
+    Termination termination;
+    termination.max_generations = options.quick ? 50 : 200;
+    scaling("parallel_genetic", "64-queens", "generations/s", options, [&](size_t threads) {
+      ThreadPool pool{ threads };
+      AliasSelection selection;
+      return double(parallel_evolve<Board>(population, QueensFitness{}, 0.1, gene_pool, 2, pool, options.seed, selection, termination).generations);
+    });
+  }
+}
+
+// ---------------------------------------------------------------------------------
+// Simulated annealing
+
+void annealing_benchmarks(const Options& options, const std::function<bool(const char*)>& selected) {
+  Random random{ options.seed };
+  int side = options.quick ? 100 : 300;
+  int steps = options.quick ? 5000 : 20000;
+  PeakFindingProblem problem{ { side / 2, side / 2 }, random_peak_grid(side, side, random), directions8() };
+  auto schedule = exp_schedule(20, 5.0 / steps, steps);
+
+  if (selected("annealing")) {
+    Latencies latencies;
+    double iterations = 0;
+    int runs = options.quick ? 50 : 200;
+    for (int run = 0; run < runs; run++) {
+      AnnealingStats stats;
+      auto start = Clock::now();
+      simulated_annealing(problem, schedule, random, &stats);
+      latencies.add(seconds_since(start));
+      iterations += stats_enabled ? stats.steps.value() : steps;
+    }
+    report("annealing", std::to_string(side) + "x" + std::to_string(side) + "-peaks", 1, runs, latencies.total(), iterations,
+           "iterations/s", &latencies);
+  }
+
+  if (selected("multi_start_annealing")) {
+    size_t restarts = options.quick ? 32 : 128;
+    scaling("multi_start_annealing", std::to_string(side) + "x" + std::to_string(side) + "-peaks", "iterations/s", options,
+            [&](size_t threads) {
+      ThreadPool pool{ threads };
+      multi_start_annealing(problem, restarts, pool, options.seed, schedule);
+      return double(restarts) * steps;
+    });
+  }
+}
+
+// ---------------------------------------------------------------------------------
+// Monte Carlo tree search
+
+void mcts_benchmarks(const Options& options, const std::function<bool(const char*)>& selected) {
+  using Game = TicTacToe<4, 4, 4>;
+  Game game;
+  size_t playouts = options.quick ? 2000 : 10000;
+
+  if (selected("mcts")) {
+    Random random{ options.seed };
+    MCTS<Game> mcts{ game };
+    Latencies latencies;
+    int runs = options.quick ? 10 : 50;
+    for (int run = 0; run < runs; run++) {
+      auto start = Clock::now();
+      mcts.search(game.initial, playouts, random);
+      latencies.add(seconds_since(start));
+    }
+    report("mcts", "4x4-tictactoe", 1, runs, latencies.total(), double(runs) * playouts, "playouts/s", &latencies);
+  }
+
+  if (selected("parallel_mcts")) {
+    scaling("parallel_mcts", "4x4-tictactoe", "playouts/s", options, [&](size_t threads) {
+      ThreadPool pool{ threads };
+      ParallelMCTS<Game> mcts{ game, pool };
+      double total = 0;
+      for (int run = 0; run < 5; run++) {
+        mcts.search(game.initial, playouts * 4, std::numeric_limits<double>::infinity(), options.seed + run);
+        total += mcts.playouts();
+      }
+      return total;
+    });
+  }
+}
+
+int main(int argc, char** argv) {
+  Options options;
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if (arg == "--quick") {
+      options.quick = true;
+    } else if (arg == "--seed" && i + 1 < argc) {
+      options.seed = std::strtoull(argv[++i], nullptr, 10);
+    } else if (arg == "--threads" && i + 1 < argc) {
+      options.threads = std::max(1ull, std::strtoull(argv[++i], nullptr, 10));
+    } else if (arg == "--filter" && i + 1 < argc) {
+      options.filter = argv[++i];
+    } else {
+      std::cerr << "usage: " << argv[0] << " [--quick] [--seed N] [--threads N] [--filter NAME]\n";
+      return 2;
+    }
+  }
+
+  // Benchmarks whose name is the filter, or all of them.
+  auto selected = [&](const char* name) { return options.filter.empty() || options.filter == name; };
+
+  {
+    JsonObject json{ std::cout };
+    json.field("benchmark", "suite")
+      .field("seed", options.seed)
+      .field("quick", options.quick)
+      .field("threads", uint64_t(options.threads))
+      .field("hardware_concurrency", uint64_t(std::thread::hardware_concurrency()))
+      .field("stats_enabled", stats_enabled);
+  }
+  std::cout << std::endl;
+
+  search_benchmarks(options, selected);
+  genetic_benchmarks(options, selected);
+  annealing_benchmarks(options, selected);
+  mcts_benchmarks(options, selected);
+}
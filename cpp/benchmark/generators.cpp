@@ -0,0 +1,128 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "../random.cpp"
+#include "../sliding-tile/sliding_tile.cpp"
+
+// ---------------------------------------------------------------------------------
+// Seeded instance generators
+
+/*
+ * Generators of benchmark instances. Each draws only from the Random it is given,
+ * so a seed names the same instances on every machine.
+ */
+
+/*
+ * The goal of the sliding-tile benchmarks: the blank first, then the tiles in
+ * order.
+ */
+template <int W, int H>
+std::array<int, W * H> tile_goal() {
+  std::array<int, W * H> goal;
+  for (int cell = 0; cell < W * H; cell++) {
+    goal[cell] = cell;
+  }
+  return goal;
+}
+
+/*
+ * A board drawn uniformly from the boards that can reach tile_goal. A
+ * permutation is solvable iff its parity equals the parity of the blank's
+ * distance to its goal cell (see SlidingTile::is_solvable); swapping two tiles
+ * flips it.
+ */
+template <int W, int H>
+std::array<int, W * H> random_tile_board(Random& random) {
+  std::array<int, W * H> board = tile_goal<W, H>();
+  for (int cell = W * H - 1; cell > 0; cell--) {
+    std::swap(board[cell], board[random.below(cell + 1)]);
+  }
+
+  int transpositions = 0;
+  std::array<bool, W * H> visited{};
+  for (int cell = 0; cell < W * H; cell++) {
+    for (int length = 0, next = cell; !visited[next]; length++) {
+      visited[next] = true;
+      next = board[next];
+      transpositions += length > 0;
+    }
+  }
+  int blank = std::find(board.begin(), board.end(), 0) - board.begin();
+  if (transpositions % 2 != (blank / W + blank % W) % 2) {
+    int first = board[0] == 0 ? 1 : 0;
+    int second = board[W * H - 1] == 0 ? W * H - 2 : W * H - 1;
+    std::swap(board[first], board[second]);
+  }
+  return board;
+}
+
+/*
+ * tile_goal scrambled by moves random moves of the blank, never undoing the
+ * previous one. Bounds the solution length by moves, for boards whose random
+ * instances are too hard to benchmark (the 15-puzzle and larger).
+ */
+template <int W, int H>
+std::array<int, W * H> random_walk_tile_board(Random& random, int moves) {
+  std::array<int, W * H> board = tile_goal<W, H>();
+  int blank = 0;
+  int previous = -1;
+  for (int step = 0; step < moves; step++) {
+    int options[4];
+    int count = 0;
+    int row = blank / W, col = blank % W;
+    if (row > 0) options[count++] = blank - W;
+    if (row < H - 1) options[count++] = blank + W;
+    if (col > 0) options[count++] = blank - 1;
+    if (col < W - 1) options[count++] = blank + 1;
+    int cell;
+    do {
+      cell = options[random.below(count)];
+    } while (cell == previous);
+    std::swap(board[blank], board[cell]);
+    previous = blank;
+    blank = cell;
+  }
+  return board;
+}
+
+/*
+ * Boards of the N-Queens problem, one queen per column, rows drawn uniformly.
+ */
+inline std::vector<std::vector<int>> random_queens_population(int boards, int n, Random& random) {
+  std::vector<std::vector<int>> population(boards, std::vector<int>(n));
+  for (auto& board : population) {
+    for (int& row : board) {
+      row = random.below(n);
+    }
+  }
+  return population;
+}
+
+/*
+ * A rows x cols grid of peaks: smooth hills (a few cones of random height and
+ * radius) plus noise, so that hill climbing meets local maxima.
+ */
+inline std::vector<std::vector<int>> random_peak_grid(int rows, int cols, Random& random, int hills = 8) {
+  std::vector<std::vector<int>> grid(rows, std::vector<int>(cols, 0));
+  for (int hill = 0; hill < hills; hill++) {
+    int row = random.below(rows), col = random.below(cols);
+    int height = 100 + random.below(900);
+    int radius = 1 + random.below(std::max(rows, cols) / 2 + 1);
+    for (int r = 0; r < rows; r++) {
+      for (int c = 0; c < cols; c++) {
+        int distance = std::max(std::abs(r - row), std::abs(c - col));
+        grid[r][c] = std::max(grid[r][c], height * std::max(radius - distance, 0) / radius);
+      }
+    }
+  }
+  for (auto& line : grid) {
+    for (int& value : line) {
+      value += random.below(10);
+    }
+  }
+  return grid;
+}
@@ -0,0 +1,233 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// ---------------------------------------------------------------------------------
+// Lock-free queues
+
+/*
+ * Unbounded multi-producer, single-consumer queue (Vyukov's node-based design).
+ *
+ * push is wait-free: one atomic exchange. pop is only called by the owning
+ * thread and never blocks; it may briefly miss an element whose push is halfway
+ * done, which then shows up on a later pop.
+ */
+template <typename T>
+struct MpscQueue {
+  MpscQueue() : head{ new QueueNode{} }, tail{ head.load() } {}
+
+  MpscQueue(const MpscQueue&) = delete;
+  MpscQueue& operator=(const MpscQueue&) = delete;
+
+  ~MpscQueue() {
+    T ignored;
+    while (pop(ignored)) {}
+    delete tail;
+  }
+
+  void push(T value) {
+    QueueNode* node = new QueueNode{ std::move(value), nullptr };
+    QueueNode* previous = head.exchange(node, std::memory_order_acq_rel);
+    previous->next.store(node, std::memory_order_release);
+  }
+
+  /*
+   * Moves the oldest element into value. Returns false if there is none.
+   */
+  bool pop(T& value) {
+    QueueNode* next = tail->next.load(std::memory_order_acquire);
+    if (!next) {
+      return false;
+    }
+    value = std::move(next->value);
+    delete tail;
+    tail = next;  // next becomes the new stub.
+    return true;
+  }
+
+private:
+  struct QueueNode {
+    T value;
+    std::atomic<QueueNode*> next;
+  };
+
+  std::atomic<QueueNode*> head;  // Last pushed node, shared by producers.
+  QueueNode* tail;               // Stub before the oldest node, consumer only.
+};
+
+// ---------------------------------------------------------------------------------
+// Thread pool
+
+/*
+ * Fixed-size pool of threads with work stealing.
+ *
+ * Every worker has its own deque of tasks. Tasks submitted from a worker go to
+ * its own deque, others are spread round-robin. A worker runs its newest task
+ * first and, when out of work, steals the oldest task of another worker.
+ *
+ * Submitting, taking and stealing a task only lock the deque involved; the
+ * task counts are atomics. The pool mutex is only taken by workers going to
+ * sleep for lack of work, by submit when a worker sleeps, and to notify wait().
+ */
+struct ThreadPool {
+  explicit ThreadPool(size_t threads = std::thread::hardware_concurrency())
+  : queues(std::max<size_t>(threads, 1)) {
+    for (auto& queue : queues) {
+      queue = std::make_unique<TaskQueue>();
+    }
+    for (size_t id = 0; id < queues.size(); id++) {
+      workers.emplace_back([this, id] { run(id); });
+    }
+  }
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  ~ThreadPool() {
+    {
+      std::lock_guard<std::mutex> lock{ mutex };
+      stopping = true;
+    }
+    wake.notify_all();
+    for (std::thread& worker : workers) {
+      worker.join();
+    }
+  }
+
+  size_t size() const {
+    return workers.size();
+  }
+
+  /*
+   * Index of the pool thread running the caller, or -1 outside the pool. Lets
+   * tasks pick per-thread scratch data.
+   */
+  static int worker_index() {
+    return current_worker;
+  }
+
+  void submit(std::function<void()> task) {
+    size_t id = current_pool == this ? current_worker : next_queue++ % queues.size();
+    pending.fetch_add(1);
+    {
+      std::lock_guard<std::mutex> lock{ queues[id]->mutex };
+      queues[id]->tasks.push_back(std::move(task));
+    }
+    // Pairs with a worker that counts itself in sleepers, then checks queued:
+    // either it sees the task, or this sees it sleeping and wakes it.
+    queued.fetch_add(1);
+    if (sleepers.load() > 0) {
+      std::lock_guard<std::mutex> lock{ mutex };
+      wake.notify_one();
+    }
+  }
+
+  /*
+   * Blocks until every submitted task has finished. Not to be called from a task.
+   */
+  void wait() {
+    std::unique_lock<std::mutex> lock{ mutex };
+    finished.wait(lock, [this] { return pending.load() == 0; });
+  }
+
+  /*
+   * Runs f(i) for every i in [begin, end) on the pool, grain indexes per task,
+   * and waits for all of them.
+   */
+  template <typename F>
+  void parallel_for(size_t begin, size_t end, F f, size_t grain = 1) {
+    grain = std::max<size_t>(grain, 1);
+    for (size_t first = begin; first < end; first += grain) {
+      size_t last = std::min(end, first + grain);
+      submit([first, last, &f] {
+        for (size_t i = first; i < last; i++) {
+          f(i);
+        }
+      });
+    }
+    wait();
+  }
+
+private:
+  struct TaskQueue {
+    std::mutex mutex;
+    std::deque<std::function<void()>> tasks;
+  };
+
+  void run(size_t id) {
+    current_pool = this;
+    current_worker = static_cast<int>(id);
+
+    std::function<void()> task;
+    while (true) {
+      if (take(id, task)) {
+        queued.fetch_sub(1);
+        task();
+        task = nullptr;
+        if (pending.fetch_sub(1) == 1) {
+          std::lock_guard<std::mutex> lock{ mutex };
+          finished.notify_all();
+        }
+        continue;
+      }
+
+      std::unique_lock<std::mutex> lock{ mutex };
+      sleepers.fetch_add(1);
+      wake.wait(lock, [this] { return stopping || queued.load() > 0; });
+      sleepers.fetch_sub(1);
+      if (stopping && queued.load() <= 0) {
+        return;  // Nothing left to run.
+      }
+    }
+  }
+
+  /*
+   * Takes the newest task of queue id, or steals the oldest one of another
+   * queue. Returns false if every queue is empty.
+   */
+  bool take(size_t id, std::function<void()>& task) {
+    for (size_t k = 0; k < queues.size(); k++) {
+      TaskQueue& queue = *queues[(id + k) % queues.size()];
+      std::lock_guard<std::mutex> lock{ queue.mutex };
+      if (!queue.tasks.empty()) {
+        if (k == 0) {
+          task = std::move(queue.tasks.back());
+          queue.tasks.pop_back();
+        } else {
+          task = std::move(queue.tasks.front());
+          queue.tasks.pop_front();
+        }
+        return true;
+      }
+    }
+    return false;
+  }
+
+  std::vector<std::unique_ptr<TaskQueue>> queues;
+  std::vector<std::thread> workers;
+  std::atomic<size_t> next_queue{ 0 };
+
+  // Signed: a task can be taken before submit counts it, which briefly takes
+  // queued below zero.
+  std::atomic<int64_t> queued{ 0 };   // Tasks in the queues.
+  std::atomic<int64_t> pending{ 0 };  // Tasks submitted and not finished.
+  std::atomic<int> sleepers{ 0 };     // Workers waiting on wake.
+
+  std::mutex mutex;  // Only for sleeping and waking.
+  std::condition_variable wake;
+  std::condition_variable finished;
+  bool stopping = false;
+
+  static inline thread_local const ThreadPool* current_pool = nullptr;
+  static inline thread_local int current_worker = -1;
+};
@@ -1,22 +1,28 @@
+#pragma once
+
 #include "../search.cpp"
 #include "../utils.cpp"
+#include "../random.cpp"
+#include "../concurrency.cpp"
+#include "../stats.cpp"
+#include "population.cpp"
+#include "queens_kernel.cpp"
+#include "selection.cpp"
 #include <algorithm>
+#include <cstdint>
 #include <cstdlib>
 #include <functional>
 #include <iostream>
 #include <ostream>
 #include <vector>
 #include <limits>
+#include <chrono>
+#include <mutex>
+#include <numeric>
+#include <thread>
 
 using namespace std;
 
-int maxValue = std::numeric_limits<int>::max();
-
-std::random_device rd;
-std::mt19937 gen(rd());  // Mersenne Twister
-std::uniform_real_distribution<> dis(0, 1);  // Gera valores entre 1 e maxValue
-std::uniform_int_distribution<> dis_int(1, maxValue);  // Gera valores entre 1 e maxValue
-
 template<typename S>
 vector<int> weighted_by(vector<S> population, function<int(S)> fitness_fn) {
   vector<int>population2;
@@ -27,18 +33,16 @@ vector<int> weighted_by(vector<S> population, function<int(S)> fitness_fn) {
   return population2;
 }
 
+/*
+ * Picks parents individuals starting at the first one whose accumulated weight
+ * goes over rnd, a number in [0, total weight).
+ */
 template<typename S>
-vector<S> weights_random_choices(vector<S> population, vector<int> weights, int parents) {
+vector<S> weights_random_choices(const vector<S>& population, const vector<int>& weights, int parents, int rnd) {
 
-  int total = 0, accumulated = 0, counter = 0;
+  int accumulated = 0, counter = 0;
   vector<S> result;
 
-  for(int weight : weights){
-    total += weight;
-  }
-
-  int rnd = dis_int(gen) % total;
-
   for(int i = 0; i < weights.size(); i++) {
     accumulated += weights[i];
 
@@ -60,8 +64,21 @@ vector<S> weights_random_choices(vector<S> population, vector<int> weights, int
 }
 
 template<typename S>
-S reproduce(S parent1, S parent2) {
-  int n = rand() % parent1.size();
+vector<S> weights_random_choices(vector<S> population, vector<int> weights, int parents) {
+
+  int total = 0;
+
+  for(int weight : weights){
+    total += weight;
+  }
+
+  int rnd = thread_random().below(total);
+  return weights_random_choices<S>(population, weights, parents, rnd);
+}
+
+template<typename S>
+S reproduce(const S& parent1, const S& parent2, Random& rng) {
+  int n = rng.below(parent1.size());
   S child {};
 
   for(int i = 0; i < n; i++){
@@ -76,9 +93,14 @@ S reproduce(S parent1, S parent2) {
 }
 
 template<typename S>
-S mutate(S child, S gene_pool) {
-  int n = rand() % child.size();
-  int gene = rand() % gene_pool.size();
+S reproduce(S parent1, S parent2) {
+  return reproduce(parent1, parent2, thread_random());
+}
+
+template<typename S>
+S mutate(S child, const S& gene_pool, Random& rng) {
+  int n = rng.below(child.size());
+  int gene = rng.below(gene_pool.size());
 
   if(child[n] == gene_pool[gene]) {
     gene = (gene+1) % gene_pool.size();
@@ -89,6 +111,11 @@ S mutate(S child, S gene_pool) {
   return child;
 }
 
+template<typename S>
+S mutate(S child, S gene_pool) {
+  return mutate(child, gene_pool, thread_random());
+}
+
 int fitness_treshold(int size) {
   return (int)(size * ((size - 1) / 2.0));
 }
@@ -105,12 +132,12 @@ int fitness_fn(S individual) {
         int current = individual[i];
         int foward_ascend_collision = individual[i] + j; 
         int foward_descend_collision = individual[i] - j;
-        bool at_bounds_upwards = foward_ascend_collision <= individual.size();
-        bool at_bounds_downwards = foward_descend_collision > 0;
 
+        // No bounds checks: target is a row, so it can only match a row. Genes may
+        // start at 0 (see the gene pool of the tests), so "> 0" missed collisions.
         if((current == target) || 
-          (at_bounds_upwards && foward_ascend_collision == target) || 
-          (at_bounds_downwards && foward_descend_collision == target)) {
+          (foward_ascend_collision == target) || 
+          (foward_descend_collision == target)) {
           collisions++;
         }
       }
@@ -120,46 +147,660 @@ int fitness_fn(S individual) {
   return fitness_treshold(size) - collisions;
 }
 
+/*
+ * Queens per row and per diagonal of an N-Queens board, with genes (rows) in
+ * [0, n]. Two queens attack each other iff they share a row or a diagonal, so
+ * the number of attacking pairs is the sum of C(k, 2) over those lines: a board
+ * is scored in O(n), and moving one queen updates the score in O(1).
+ */
+struct QueensBoard {
+  template<typename S>
+  void assign(const S& individual) {
+    size = individual.size();
+    genes.assign(individual.begin(), individual.end());
+    rows.assign(size + 1, 0);
+    diagonals.assign(2 * size + 1, 0);
+    anti_diagonals.assign(2 * size + 1, 0);
+    collisions = 0;
+    for(int column = 0; column < size; column++) {
+      place(column, genes[column]);
+    }
+  }
+
+  /*
+   * Moves the queen of column to row.
+   */
+  void move(int column, int row) {
+    int old_row = genes[column];
+    collisions -= --rows[old_row] + --diagonals[old_row - column + size] + --anti_diagonals[old_row + column];
+    place(column, row);
+  }
+
+  int fitness() const {
+    return fitness_treshold(size) - collisions;
+  }
+
+  int gene(int column) const {
+    return genes[column];
+  }
+
+private:
+  void place(int column, int row) {
+    genes[column] = row;
+    collisions += rows[row]++ + diagonals[row - column + size]++ + anti_diagonals[row + column]++;
+  }
+
+  int size = 0;
+  int collisions = 0;
+  vector<int> genes;
+  vector<int> rows;
+  vector<int> diagonals;       // Indexed by row - column + size.
+  vector<int> anti_diagonals;  // Indexed by row + column.
+};
+
+/*
+ * Evaluators score the children of genectic_algoritm. score(child) returns the
+ * fitness of a new child; mutate(child, gene_pool, rng), called right after score
+ * on the same child, mutates it as mutate() does and returns its new fitness.
+ * mutate(child, gene_pool) draws from thread_random(). The genetic algorithm passes the
+ * children as GeneSpans into its flat populations.
+ */
+
+/*
+ * Evaluator for any fitness function: mutating costs a full evaluation.
+ */
+template<typename S>
+struct FunctionFitness {
+  explicit FunctionFitness(function<int(S)> fitness_fn) : fitness_fn{ fitness_fn } {}
+
+  int score(const S& child) {
+    return fitness_fn(child);
+  }
+
+  int mutate(S& child, const S& gene_pool, Random& rng) {
+    child = ::mutate(child, gene_pool, rng);
+    return fitness_fn(child);
+  }
+
+  int mutate(S& child, const S& gene_pool) {
+    return mutate(child, gene_pool, thread_random());
+  }
+
+  template<typename Gene>
+  int score(GeneSpan<Gene> child) {
+    scratch.assign(child.begin(), child.end());
+    return fitness_fn(scratch);
+  }
+
+  template<typename Gene, typename Pool>
+  int mutate(GeneSpan<Gene> child, const Pool& gene_pool, Random& rng) {
+    mutate_in_place(child, gene_pool, rng);
+    return score(child);
+  }
+
+  function<int(S)> fitness_fn;
+  S scratch;  // Spans are copied into it, fitness_fn takes an S.
+};
+
+/*
+ * N-Queens evaluator: scores a child in O(n) and a mutation in O(1), keeping the
+ * counters of the last scored child.
+ */
+struct QueensFitness {
+  template<typename S>
+  int operator()(const S& individual) {
+    return score(individual);
+  }
+
+  template<typename S>
+  int score(const S& child) {
+    board.assign(child);
+    return board.fitness();
+  }
+
+  template<typename S, typename Pool>
+  int mutate(S& child, const Pool& gene_pool, Random& rng) {
+    // Same draws as mutate().
+    int n = rng.below(child.size());
+    int gene = rng.below(gene_pool.size());
+
+    if(child[n] == gene_pool[gene]) {
+      gene = (gene+1) % gene_pool.size();
+    };
+
+    child[n] = gene_pool[gene];
+    board.move(n, child[n]);
+    return board.fitness();
+  }
+
+  template<typename S>
+  int mutate(S& child, const S& gene_pool) {
+    return mutate(child, gene_pool, thread_random());
+  }
+
+  QueensBoard board;
+};
+
 template <typename S>
 S find_fittest_individual(const std::vector<S>& population, function<int(S)> fitness_fn) {
   S largest_elem = population[0];
+  int largest_fitness = fitness_fn(largest_elem);
 
   for (int i = 1; i < population.size(); ++i) {
-    if (population[i] > largest_elem) {
+    int fitness = fitness_fn(population[i]);
+    if (fitness > largest_fitness) {
       largest_elem = population[i]; 
+      largest_fitness = fitness;
     }
   }
 
   return largest_elem;
 }
 
+// ---------------------------------------------------------------------------------
+// Termination
+
+/*
+ * When a run of the genetic algorithm gives up without reaching the fitness
+ * threshold. Every limit is checked between generations.
+ */
+struct Termination {
+  int max_generations = 50000;
+  double max_seconds = std::numeric_limits<double>::infinity();
+  uint64_t max_evaluations = std::numeric_limits<uint64_t>::max();  // Individuals scored.
+  int max_stagnation = std::numeric_limits<int>::max();  // Generations without a fitter best.
+};
+
+enum class StopReason { solved, generations, time, evaluations, stagnation };
+
+inline const char* to_string(StopReason reason) {
+  switch(reason) {
+    case StopReason::solved: return "solved";
+    case StopReason::generations: return "generations";
+    case StopReason::time: return "time";
+    case StopReason::evaluations: return "evaluations";
+    default: return "stagnation";
+  }
+}
+
+/*
+ * The fittest individual of a run, and what the run took. phases holds the time
+ * spent scoring the initial population, preparing the selection and breeding
+ * (summed over the islands of an island run).
+ */
+template<typename S>
+struct GAResult {
+  bool solved() const {
+    return reason == StopReason::solved;
+  }
+
+  S best;
+  int fitness = std::numeric_limits<int>::min();
+  StopReason reason = StopReason::generations;
+  int generations = 0;
+  uint64_t evaluations = 0;
+  double seconds = 0;
+  PhaseTimes phases;
+};
+
+/*
+ * The statistics of a run, without the individual.
+ */
 template<typename S>
-S genectic_algoritm(vector<S> population, function<int(S)> fitness_fn, double mutation_chance, S gene_pool, int parents) {
+void write_json(std::ostream& out, const GAResult<S>& result) {
+  JsonObject json{ out };
+  json.field("enabled", stats_enabled)
+    .field("fitness", result.fitness)
+    .field("reason", to_string(result.reason))
+    .field("generations", result.generations)
+    .field("evaluations", result.evaluations)
+    .field("seconds", result.seconds)
+    .field("phases", result.phases);
+}
+
+/*
+ * Keeps the best individual seen so far, by copying it out of a generation when
+ * a fitter one is born, and applies a Termination between generations.
+ */
+template<typename Gene>
+struct EvolutionProgress {
+  EvolutionProgress(const Termination& termination, int treshold)
+  : termination{ termination }, treshold{ treshold }, start{ std::chrono::steady_clock::now() } {}
+
+  /*
+   * Records a scored generation. Returns true when the run has to stop, with
+   * the reason in reason.
+   */
+  bool record(const Population<Gene>& population, const vector<int>& weights) {
+    evaluations += weights.size();
+    size_t fittest = std::max_element(weights.begin(), weights.end()) - weights.begin();
+    if(weights.empty() || weights[fittest] <= fitness) {
+      stagnation++;
+    } else {
+      fitness = weights[fittest];
+      best.assign(population[fittest].begin(), population[fittest].end());
+      stagnation = 0;
+    }
+
+    if(fitness == treshold) reason = StopReason::solved;
+    else if(generations >= termination.max_generations) reason = StopReason::generations;
+    else if(evaluations >= termination.max_evaluations) reason = StopReason::evaluations;
+    else if(stagnation >= termination.max_stagnation) reason = StopReason::stagnation;
+    else if(elapsed() >= termination.max_seconds) reason = StopReason::time;
+    else return false;
+    return true;
+  }
+
+  double elapsed() const {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  }
+
+  template<typename S>
+  GAResult<S> result() const {
+    GAResult<S> result;
+    result.best = S(best.begin(), best.end());
+    result.fitness = fitness;
+    result.reason = reason;
+    result.generations = generations;
+    result.evaluations = evaluations;
+    result.seconds = elapsed();
+    result.phases = phases;
+    return result;
+  }
 
-  int attemptNumber = 0;
-  int treshold = fitness_treshold(population[0].size());
+  Termination termination;
+  int treshold;
+  std::chrono::steady_clock::time_point start;
+  int generations = 0;  // Bred so far, incremented by the caller.
+  uint64_t evaluations = 0;
+  int stagnation = 0;
+  int fitness = std::numeric_limits<int>::min();
+  vector<Gene> best;
+  StopReason reason = StopReason::generations;
+  PhaseTimes phases;
+};
+
+/*
+ * Breeds children [begin, end) of the next generation into their slots, drawing
+ * from rng only: parents from the prepared selection, then crossover, scoring and
+ * maybe a mutation. chosen holds the parents drawn per child.
+ */
+template<typename Gene, typename Selection, typename Evaluator>
+void breed(
+  const Population<Gene>& population,
+  const Selection& selection,
+  Evaluator& evaluator,
+  const vector<Gene>& genes,
+  double mutation_chance,
+  Random& rng,
+  vector<size_t>& chosen,
+  Population<Gene>& new_population,
+  vector<int>& new_weights,
+  size_t begin,
+  size_t end
+) {
+  for(size_t i = begin; i < end; i++) {
+    for(size_t& parent : chosen) parent = selection(rng);
+    GeneSpan<Gene> child = new_population[i];
+    crossover(population[chosen[0]], population[chosen[1]], child, rng);
+    int fitness = evaluator.score(child);
+    if(rng.chance(mutation_chance)) fitness = evaluator.mutate(child, genes, rng);
+    new_weights[i] = fitness;
+  }
+}
+
+/*
+ * Evolves population until an individual reaches the fitness threshold, or until
+ * termination gives up, and returns the fittest individual seen with the
+ * statistics of the run. Every individual is scored once, when it is born: the
+ * fitness of the children is kept as the weights of the next generation.
+ *
+ * selection is prepared once per generation and draws each of the parents of a
+ * child independently; the child is bred from the first two.
+ *
+ * Generations live in two flat Populations of 16-bit genes, swapped after each
+ * generation: children are bred and mutated in place in their slots, and only
+ * the returned individual is converted back to an S.
+ */
+template<typename S, typename Evaluator, typename Selection>
+GAResult<S> evolve(
+  const vector<S>& initial_population,
+  Evaluator& evaluator,
+  double mutation_chance,
+  const S& gene_pool,
+  int parents,
+  Selection& selection,
+  const Termination& termination = {},
+  Random& random = thread_random()
+) {
+
+  using Gene = uint16_t;
+  Population<Gene> population(initial_population);
+  Population<Gene> new_population(population.size(), population.length);
+  vector<Gene> genes;
+  for(const auto& gene : gene_pool) genes.push_back(Population<Gene>::to_gene(gene));
+
+  EvolutionProgress<Gene> progress(termination, fitness_treshold(population.length));
   vector<int> weights;
+  {
+    PhaseTimer timer{ progress.phases, "initialize" };
+    for(size_t i = 0; i < population.size(); i++) {
+      weights.push_back(evaluator.score(population[i]));
+    }
+  }
+  vector<int> new_weights(weights.size());
+  vector<size_t> chosen(std::max(parents, 2));
+
+  while(!progress.record(population, weights)) {
+    progress.generations++;
+    {
+      PhaseTimer timer{ progress.phases, "selection" };
+      selection.prepare(weights);
+    }
+    {
+      PhaseTimer timer{ progress.phases, "breeding" };
+      breed(population, selection, evaluator, genes, mutation_chance, random, chosen, new_population, new_weights, 0, population.size());
+    }
+    population.swap(new_population);
+    weights.swap(new_weights);
+  }
+
+  return progress.template result<S>();
+}
+
+/*
+ * The fittest individual of evolve; the whole result, statistics included, is
+ * copied to *result if given.
+ */
+template<typename S, typename Selection = AliasSelection>
+S genectic_algoritm(vector<S> population, function<int(S)> fitness_fn, double mutation_chance, S gene_pool, int parents, Selection selection = {}, Termination termination = {}, GAResult<S>* result = nullptr) {
+  FunctionFitness<S> evaluator{ fitness_fn };
+  GAResult<S> run = evolve<S>(population, evaluator, mutation_chance, gene_pool, parents, selection, termination);
+  if(result) *result = run;
+  return run.best;
+}
+
+/*
+ * N-Queens version, scoring children incrementally.
+ */
+template<typename S, typename Selection = AliasSelection>
+S genectic_algoritm(vector<S> population, QueensFitness fitness, double mutation_chance, S gene_pool, int parents, Selection selection = {}, Termination termination = {}, GAResult<S>* result = nullptr) {
+  GAResult<S> run = evolve<S>(population, fitness, mutation_chance, gene_pool, parents, selection, termination);
+  if(result) *result = run;
+  return run.best;
+}
+
+// ---------------------------------------------------------------------------------
+// Parallel genetic algorithm
+
+/*
+ * evolve with the scoring and breeding of every generation spread over a thread
+ * pool.
+ *
+ * The population is cut into one slice per pool thread. Each slice has its own
+ * evaluator (a copy of evaluator) and its own stream, split from a Random seeded
+ * with seed, and breeds the children of its slice into their slots of the next
+ * generation. Which thread runs a slice does not matter, so a run only depends on
+ * seed and the size of the pool.
+ */
+template<typename S, typename Evaluator, typename Selection>
+GAResult<S> parallel_evolve(
+  const vector<S>& initial_population,
+  const Evaluator& evaluator,
+  double mutation_chance,
+  const S& gene_pool,
+  int parents,
+  ThreadPool& pool,
+  uint64_t seed,
+  Selection& selection,
+  const Termination& termination = {}
+) {
+  struct Slice {
+    Evaluator evaluator;
+    Random rng;
+    vector<size_t> chosen;
+  };
+
+  using Gene = uint16_t;
+  Population<Gene> population(initial_population);
+  Population<Gene> new_population(population.size(), population.length);
+  vector<Gene> genes;
+  for(const auto& gene : gene_pool) genes.push_back(Population<Gene>::to_gene(gene));
+
+  size_t size = population.size();
+  size_t slices = std::min(pool.size(), size);
+  vector<Slice> slice;
+  Random root(seed);
+  for(size_t k = 0; k < slices; k++) {
+    slice.push_back(Slice{ evaluator, root.split(), vector<size_t>(std::max(parents, 2)) });
+  }
+  auto first = [&](size_t k) { return k * size / slices; };
+
+  EvolutionProgress<Gene> progress(termination, fitness_treshold(population.length));
+  vector<int> weights(size);
+  {
+    PhaseTimer timer{ progress.phases, "initialize" };
+    pool.parallel_for(0, slices, [&](size_t k) {
+      for(size_t i = first(k); i < first(k + 1); i++) {
+        weights[i] = slice[k].evaluator.score(population[i]);
+      }
+    });
+  }
+
+  vector<int> new_weights(size);
+  while(!progress.record(population, weights)) {
+    progress.generations++;
+    {
+      PhaseTimer timer{ progress.phases, "selection" };
+      selection.prepare(weights);
+    }
+    {
+      PhaseTimer timer{ progress.phases, "breeding" };
+      pool.parallel_for(0, slices, [&](size_t k) {
+        Slice& own = slice[k];
+        breed(population, selection, own.evaluator, genes, mutation_chance, own.rng, own.chosen, new_population, new_weights, first(k), first(k + 1));
+      });
+    }
+    population.swap(new_population);
+    weights.swap(new_weights);
+  }
+
+  return progress.template result<S>();
+}
+
+template<typename S, typename Selection = AliasSelection>
+S parallel_genectic_algoritm(vector<S> population, function<int(S)> fitness_fn, double mutation_chance, S gene_pool, int parents, ThreadPool& pool, uint64_t seed, Selection selection = {}, Termination termination = {}) {
+  return parallel_evolve<S>(population, FunctionFitness<S>{ fitness_fn }, mutation_chance, gene_pool, parents, pool, seed, selection, termination).best;
+}
+
+/*
+ * N-Queens version, scoring children incrementally.
+ */
+template<typename S, typename Selection = AliasSelection>
+S parallel_genectic_algoritm(vector<S> population, QueensFitness fitness, double mutation_chance, S gene_pool, int parents, ThreadPool& pool, uint64_t seed, Selection selection = {}, Termination termination = {}) {
+  return parallel_evolve<S>(population, fitness, mutation_chance, gene_pool, parents, pool, seed, selection, termination).best;
+}
+
+// ---------------------------------------------------------------------------------
+// Island model
+
+enum class MigrationTopology {
+  ring,             // Island k sends to island k + 1.
+  fully_connected,  // Every island sends to every other one.
+};
+
+struct IslandOptions {
+  int islands = 4;
+  int interval = 25;  // Generations between migrations.
+  int migrants = 2;   // Best individuals sent to each neighbour.
+  MigrationTopology topology = MigrationTopology::ring;
+  uint64_t seed = 0;
+};
+
+/*
+ * Island-model genetic algorithm: the population is cut into options.islands
+ * sub-populations that evolve at the same time, each on its own thread with its
+ * own evaluator, selection and stream (split from a Random seeded with
+ * options.seed).
+ *
+ * Every options.interval generations an island sends copies of its best
+ * individuals to its neighbours through their lock-free inboxes, and replaces its
+ * worst individuals with the migrants it has received. Islands never wait for
+ * migrants, so runs are not reproducible across runs, unlike
+ * parallel_genectic_algoritm.
+ *
+ * Stops as soon as an island reaches the fitness threshold, or once termination
+ * stopped every island (its limits apply to each island on its own). Returns
+ * the fittest individual found, with the generations of the longest island and
+ * the evaluations of all of them.
+ */
+template<typename S, typename Evaluator, typename Selection>
+GAResult<S> island_evolve(
+  const vector<S>& initial_population,
+  const Evaluator& evaluator,
+  double mutation_chance,
+  const S& gene_pool,
+  int parents,
+  const IslandOptions& options,
+  const Selection& selection,
+  const Termination& termination = {}
+) {
+  using Gene = uint16_t;
+
+  struct Migrant {
+    vector<Gene> genes;
+    int fitness;
+  };
+
+  struct Island {
+    Population<Gene> population, new_population;
+    vector<int> weights, new_weights;
+    Evaluator evaluator;
+    Selection selection;
+    Random rng;
+    vector<size_t> chosen;
+    vector<size_t> order;  // Individuals by fitness, for migrations.
+    MpscQueue<vector<Migrant>> inbox;
+    EvolutionProgress<Gene> progress;
+  };
 
-  while(attemptNumber++ < 50000) {
-    vector<S> new_population; 
-    weights = weighted_by<S>(population, fitness_fn);
-    
-    for(int i = 1; i < weights.size(); i++) {
-      if(weights[i] == treshold) {
-        cout << attemptNumber << endl; 
-        return population[i];
+  vector<Gene> genes;
+  for(const auto& gene : gene_pool) genes.push_back(Population<Gene>::to_gene(gene));
+  int treshold = fitness_treshold(initial_population[0].size());
+
+  size_t count = std::max<size_t>(1, std::min<size_t>(options.islands, initial_population.size() / 2));
+  vector<std::unique_ptr<Island>> islands;
+  Random root(options.seed);
+  for(size_t k = 0; k < count; k++) {
+    auto first = initial_population.begin() + k * initial_population.size() / count;
+    auto last = initial_population.begin() + (k + 1) * initial_population.size() / count;
+    islands.push_back(std::unique_ptr<Island>(new Island{
+      Population<Gene>(vector<S>(first, last)), Population<Gene>(last - first, initial_population[0].size()),
+      {}, vector<int>(last - first), evaluator, selection, root.split(), vector<size_t>(std::max(parents, 2)), {}, {},
+      EvolutionProgress<Gene>(termination, treshold)
+    }));
+  }
+
+  std::atomic<bool> done{ false };
+
+  auto migrate = [&](size_t k) {
+    Island& island = *islands[k];
+    size_t size = island.population.size();
+    size_t migrants = std::min<size_t>(options.migrants, size);
+    island.order.resize(size);
+    std::iota(island.order.begin(), island.order.end(), 0);
+    std::sort(island.order.begin(), island.order.end(), [&](size_t a, size_t b) { return island.weights[a] > island.weights[b]; });
+
+    vector<Migrant> sent;
+    for(size_t m = 0; m < migrants; m++) {
+      auto genes_of = island.population[island.order[m]];
+      sent.push_back(Migrant{ vector<Gene>(genes_of.begin(), genes_of.end()), island.weights[island.order[m]] });
+    }
+    for(size_t to = 0; to < count; to++) {
+      bool neighbour = options.topology == MigrationTopology::ring ? to == (k + 1) % count : to != k;
+      if(neighbour && to != k && !sent.empty()) islands[to]->inbox.push(sent);
+    }
+
+    // The received migrants replace the worst individuals.
+    vector<Migrant> received;
+    size_t worst = size;
+    while(island.inbox.pop(received)) {
+      for(Migrant& migrant : received) {
+        if(worst == migrants) break;  // Never replaces the ones just sent.
+        size_t i = island.order[--worst];
+        std::copy(migrant.genes.begin(), migrant.genes.end(), island.population[i].begin());
+        island.weights[i] = migrant.fitness;
       }
     }
+  };
 
-    for(int i = 0; i < population.size(); i++) {
-      vector<S> result = weights_random_choices<S>(population, weights, parents);
-      S child = reproduce<S>(result[0], result[1]);
-      if(rand() / static_cast<double>(RAND_MAX) < mutation_chance) child = mutate<S>(child, gene_pool);
-      new_population.push_back(child);
+  auto run = [&](size_t k) {
+    Island& island = *islands[k];
+    {
+      PhaseTimer timer{ island.progress.phases, "initialize" };
+      for(size_t i = 0; i < island.population.size(); i++) {
+        island.weights.push_back(island.evaluator.score(island.population[i]));
+      }
     }
-    population = new_population;
+
+    while(!island.progress.record(island.population, island.weights) && !done.load(std::memory_order_relaxed)) {
+      int generation = ++island.progress.generations;
+      if(count > 1 && generation % std::max(options.interval, 1) == 0) {
+        migrate(k);
+      }
+
+      {
+        PhaseTimer timer{ island.progress.phases, "selection" };
+        island.selection.prepare(island.weights);
+      }
+      {
+        PhaseTimer timer{ island.progress.phases, "breeding" };
+        breed(island.population, island.selection, island.evaluator, genes, mutation_chance, island.rng, island.chosen,
+              island.new_population, island.new_weights, 0, island.population.size());
+      }
+      island.population.swap(island.new_population);
+      island.weights.swap(island.new_weights);
+    }
+    if(island.progress.reason == StopReason::solved) {
+      done = true;
+    }
+  };
+
+  vector<std::thread> threads;
+  for(size_t k = 0; k < count; k++) {
+    threads.emplace_back(run, k);
   }
+  for(std::thread& thread : threads) {
+    thread.join();
+  }
+
+  GAResult<S> result;
+  for(const auto& island : islands) {
+    GAResult<S> own = island->progress.template result<S>();
+    if(own.fitness > result.fitness) {
+      result.best = own.best;
+      result.fitness = own.fitness;
+      result.reason = own.reason;
+    }
+    result.generations = std::max(result.generations, own.generations);
+    result.evaluations += own.evaluations;
+    result.seconds = std::max(result.seconds, own.seconds);
+    for(const auto& [phase, seconds] : own.phases.phases) {
+      result.phases.add(phase, seconds);
+    }
+  }
+  return result;
+}
 
-  return find_fittest_individual(population, fitness_fn);
+template<typename S, typename Selection = AliasSelection>
+S island_genectic_algoritm(vector<S> population, function<int(S)> fitness_fn, double mutation_chance, S gene_pool, int parents, IslandOptions options = {}, Selection selection = {}, Termination termination = {}) {
+  return island_evolve<S>(population, FunctionFitness<S>{ fitness_fn }, mutation_chance, gene_pool, parents, options, selection, termination).best;
 }
 
+/*
+ * N-Queens version, scoring children incrementally.
+ */
+template<typename S, typename Selection = AliasSelection>
+S island_genectic_algoritm(vector<S> population, QueensFitness fitness, double mutation_chance, S gene_pool, int parents, IslandOptions options = {}, Selection selection = {}, Termination termination = {}) {
+  return island_evolve<S>(population, fitness, mutation_chance, gene_pool, parents, options, selection, termination).best;
+}
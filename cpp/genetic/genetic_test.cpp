@@ -35,6 +35,43 @@ TEST_CASE("fitness function") {
   REQUIRE(fitness_fn<state>(collision_6) == 22);
   REQUIRE(fitness_fn<state>(collision_28) == 0);
   REQUIRE(fitness_fn<state>(collision) == 27);
+  REQUIRE(fitness_fn<state>({1, 0}) == 0);  // Diagonal collision on row 0.
+}
+
+TEST_CASE("queens board counters") {
+  QueensBoard board;
+  srand(42);
+
+  for(int size : {1, 2, 8, 50}) {
+    state individual(size);
+    for(int k = 0; k < 20; k++) {
+      for(int& gene : individual) gene = rand() % (size + 1);
+      board.assign(individual);
+      REQUIRE(board.fitness() == fitness_fn<state>(individual));
+
+      for(int m = 0; m < 20; m++) {
+        int column = rand() % size;
+        individual[column] = rand() % (size + 1);
+        board.move(column, individual[column]);
+        REQUIRE(board.fitness() == fitness_fn<state>(individual));
+      }
+    }
+  }
+}
+
+TEST_CASE("queens fitness mutates like mutate") {
+  state queen_positions = {3,2,7,4,8,5,5,2};
+  state gene_pool = {1,2,3,4,5,6,7,8};
+  QueensFitness fitness;
+
+  Random random(9), same(9);
+  state expected = mutate<state>(queen_positions, gene_pool, random);
+  state child = queen_positions;
+  fitness.score(child);
+  int mutated = fitness.mutate(child, gene_pool, same);
+
+  REQUIRE(child == expected);
+  REQUIRE(mutated == fitness_fn<state>(child));
 }
 
 vector<state> population;
@@ -69,18 +106,300 @@ TEST_CASE("weightsr_random_choices function") {
 TEST_CASE("integrate all function") {
 
   int size = 8;
-  cout << "enter the board size: "; 
-  std::cin >> size;
+  seed_thread_random(8);
   int populationSize = 100;
   vector<state> population = generateRandomPopulation<state>(populationSize, size);
   // for(int i = 0; i < population.size(); i++) print_array("individual: ", population[i], i);
   double probability = 0.1;
   state gene_pool(size, 0);
 
-  for(int i = 0; i < gene_pool.size(); i++) gene_pool[i] = i;
+  for(size_t i = 0; i < gene_pool.size(); i++) gene_pool[i] = i;
   state result = genectic_algoritm<state>(population, fitness_fn<state>, probability, gene_pool, 2);
   REQUIRE(fitness_fn<state>(result) == fitness_treshold(size));
   print_array("result: ", result);
 }
 
 
+
+TEST_CASE("genetic algorithm with incremental fitness") {
+  int size = 8;
+  seed_thread_random(3);
+  vector<state> population = generateRandomPopulation<state>(100, size);
+  state gene_pool(size, 0);
+
+  for(size_t i = 0; i < gene_pool.size(); i++) gene_pool[i] = i;
+  state result = genectic_algoritm<state>(population, QueensFitness{}, 0.1, gene_pool, 2);
+  REQUIRE(fitness_fn<state>(result) == fitness_treshold(size));
+}
+
+TEST_CASE("parallel genetic algorithm") {
+  int size = 8;
+  seed_thread_random(5);
+  vector<state> population = generateRandomPopulation<state>(200, size);
+  state gene_pool(size, 0);
+
+  for(size_t i = 0; i < gene_pool.size(); i++) gene_pool[i] = i;
+  ThreadPool pool(4);
+  state result = parallel_genectic_algoritm<state>(population, QueensFitness{}, 0.1, gene_pool, 2, pool, 11);
+  REQUIRE(fitness_fn<state>(result) == fitness_treshold(size));
+
+  // Same seed and pool size, same run.
+  REQUIRE(parallel_genectic_algoritm<state>(population, QueensFitness{}, 0.1, gene_pool, 2, pool, 11) == result);
+
+  state with_function = parallel_genectic_algoritm<state>(population, fitness_fn<state>, 0.1, gene_pool, 2, pool, 11);
+  REQUIRE(with_function == result);  // Both evaluators draw the same numbers.
+}
+
+template<typename Selection>
+vector<double> selection_frequencies(Selection& selection, const vector<int>& weights, int draws) {
+  Random rng(7);
+  vector<double> frequencies(weights.size());
+  selection.prepare(weights);
+  for(int k = 0; k < draws; k++) frequencies[selection(rng)] += 1.0 / draws;
+  return frequencies;
+}
+
+TEST_CASE("fitness-proportional selection") {
+  vector<int> weights = {1, 0, 3, 6, 0, 10};
+  RouletteSelection roulette;
+  AliasSelection alias;
+
+  for(const vector<double>& frequencies : {selection_frequencies(roulette, weights, 200000), selection_frequencies(alias, weights, 200000)}) {
+    for(size_t i = 0; i < weights.size(); i++) {
+      REQUIRE(frequencies[i] == Approx(weights[i] / 20.0).margin(0.01));
+    }
+  }
+
+  vector<int> zeros(4, 0);
+  for(double frequency : selection_frequencies(alias, zeros, 100000)) {
+    REQUIRE(frequency == Approx(0.25).margin(0.01));
+  }
+  for(double frequency : selection_frequencies(roulette, zeros, 100000)) {
+    REQUIRE(frequency == Approx(0.25).margin(0.01));
+  }
+}
+
+TEST_CASE("tournament and rank selection") {
+  vector<int> weights = {5, 100, 1, 7};
+
+  TournamentSelection tournament;
+  tournament.size = 2;
+  vector<double> frequencies = selection_frequencies(tournament, weights, 100000);
+  // The fittest of 4 wins unless both entrants are someone else: 1 - (3/4)^2.
+  REQUIRE(frequencies[1] == Approx(7.0 / 16).margin(0.01));
+  REQUIRE(frequencies[2] == Approx(1.0 / 16).margin(0.01));
+
+  RankSelection rank;
+  frequencies = selection_frequencies(rank, weights, 100000);
+  // Ranks 2, 4, 1, 3 out of 10, whatever the scale of the fitness.
+  REQUIRE(frequencies[0] == Approx(0.2).margin(0.01));
+  REQUIRE(frequencies[1] == Approx(0.4).margin(0.01));
+  REQUIRE(frequencies[2] == Approx(0.1).margin(0.01));
+  REQUIRE(frequencies[3] == Approx(0.3).margin(0.01));
+}
+
+TEST_CASE("genetic algorithm with tournament selection") {
+  int size = 8;
+  seed_thread_random(4);
+  vector<state> population = generateRandomPopulation<state>(100, size);
+  state gene_pool(size, 0);
+
+  for(size_t i = 0; i < gene_pool.size(); i++) gene_pool[i] = i;
+  TournamentSelection tournament;
+  tournament.size = 3;
+  state result = genectic_algoritm<state>(population, QueensFitness{}, 0.2, gene_pool, 2, tournament);
+  REQUIRE(fitness_fn<state>(result) == fitness_treshold(size));
+
+  ThreadPool pool(2);
+  result = parallel_genectic_algoritm<state>(population, QueensFitness{}, 0.2, gene_pool, 2, pool, 3, RankSelection{});
+  REQUIRE(fitness_fn<state>(result) == fitness_treshold(size));
+}
+
+TEST_CASE("flat population") {
+  vector<state> individuals = {{3,2,7,4,8,5,5,2}, {8,1,7,2,6,3,4,2}};
+  Population<uint16_t> population(individuals);
+  REQUIRE(population.size() == 2);
+  REQUIRE(population.genes.size() == 16);
+  REQUIRE(population.individual<state>(1) == individuals[1]);
+
+  // In place, with the same draws as reproduce() and mutate().
+  Population<uint16_t> next(2, 8);
+  state gene_pool = {1,2,3,4,5,6,7,8};
+  Random random(21), same(21);
+  state expected = mutate<state>(reproduce<state>(individuals[0], individuals[1], random), gene_pool, random);
+  crossover(population[0], population[1], next[0], same);
+  mutate_in_place(next[0], gene_pool, same);
+  REQUIRE(next.individual<state>(0) == expected);
+
+  REQUIRE_THROWS_AS(Population<uint8_t>(vector<state>{{1, 300}}), std::invalid_argument);
+  REQUIRE_THROWS_AS(Population<uint16_t>(vector<state>{{1, -1}}), std::invalid_argument);
+  REQUIRE_THROWS_AS(Population<uint16_t>(vector<state>{{1, 2}, {1}}), std::invalid_argument);
+}
+
+TEST_CASE("vectorized collision kernels") {
+  std::mt19937 rng(17);
+  vector<QueensKernel> kernels;
+  for(QueensKernel kernel : {QueensKernel::scalar, QueensKernel::sse2, QueensKernel::avx2}) {
+    if(queens_kernel_supported(kernel)) kernels.push_back(kernel);
+  }
+
+  for(int size : {0, 1, 2, 7, 8, 9, 16, 17, 33, 100}) {
+    for(int range : {size + 1, 3, 40000}) {
+      for(int k = 0; k < 20; k++) {
+        state individual(size);
+        for(int& gene : individual) gene = rng() % range;
+        vector<uint16_t> genes(individual.begin(), individual.end());
+        for(QueensKernel kernel : kernels) {
+          REQUIRE(queens_fitness(genes.data(), genes.size(), kernel) == fitness_fn<state>(individual));
+        }
+      }
+    }
+  }
+
+  vector<state> boards = generateRandomPopulation<state>(50, 12);
+  Population<uint16_t> population(boards);
+  vector<int> fitness;
+  queens_fitness_batch(population, fitness);
+  for(size_t i = 0; i < boards.size(); i++) {
+    REQUIRE(fitness[i] == fitness_fn<state>(boards[i]));
+  }
+}
+
+TEST_CASE("island genetic algorithm") {
+  int size = 8;
+  seed_thread_random(8);
+  vector<state> population = generateRandomPopulation<state>(400, size);
+  state gene_pool(size, 0);
+  for(size_t i = 0; i < gene_pool.size(); i++) gene_pool[i] = i;
+
+  IslandOptions options;
+  options.islands = 4;
+  options.interval = 5;
+  options.migrants = 3;
+  options.seed = 2;
+  state result = island_genectic_algoritm<state>(population, QueensFitness{}, 0.2, gene_pool, 2, options);
+  REQUIRE(fitness_fn<state>(result) == fitness_treshold(size));
+
+  options.topology = MigrationTopology::fully_connected;
+  result = island_genectic_algoritm<state>(population, fitness_fn<state>, 0.2, gene_pool, 2, options);
+  REQUIRE(fitness_fn<state>(result) == fitness_treshold(size));
+
+  // Out of generations: the fittest individual seen is returned.
+  Termination termination;
+  termination.max_generations = 0;
+  result = island_genectic_algoritm<state>(population, QueensFitness{}, 0.2, gene_pool, 2, options, AliasSelection{}, termination);
+  int best = 0;
+  for(const state& individual : population) best = std::max(best, fitness_fn<state>(individual));
+  REQUIRE(fitness_fn<state>(result) == best);
+}
+
+TEST_CASE("find fittest individual") {
+  vector<state> individuals = {{1,2,3,4,5,6,7,8}, {8,2,5,3,1,7,4,6}, {4,7,3,6,2,5,8,1}};
+  REQUIRE(find_fittest_individual<state>(individuals, fitness_fn<state>) == individuals[1]);
+}
+
+TEST_CASE("genetic algorithm termination") {
+  int size = 8;
+  state gene_pool(size, 0);
+  for(size_t i = 0; i < gene_pool.size(); i++) gene_pool[i] = i;
+  seed_thread_random(12);
+  vector<state> population = generateRandomPopulation<state>(50, size);
+  QueensFitness fitness;
+  AliasSelection selection;
+
+  SECTION("a solution at index 0 is found") {
+    population[0] = {7,1,4,2,0,6,3,5};
+    GAResult<state> result = evolve<state>(population, fitness, 0.1, gene_pool, 2, selection);
+    REQUIRE(result.solved());
+    REQUIRE(result.best == population[0]);
+    REQUIRE(result.generations == 0);
+    REQUIRE(result.evaluations == 50);
+  }
+
+  // Without mutation, a population of copies of one board never improves, so
+  // these runs cannot solve and always stop on their limit.
+  vector<state> copies(20, state{8,3,5,3,1,7,4,6});
+
+  SECTION("generations") {
+    Termination termination;
+    termination.max_generations = 3;
+    GAResult<state> result = evolve<state>(copies, fitness, 0.0, gene_pool, 2, selection, termination);
+    REQUIRE(result.reason == StopReason::generations);
+    REQUIRE(result.generations == 3);
+    REQUIRE(result.evaluations == 80);
+    REQUIRE(result.fitness == fitness_fn<state>(result.best));
+  }
+
+  SECTION("evaluations") {
+    Termination termination;
+    termination.max_evaluations = 110;
+    GAResult<state> result = evolve<state>(copies, fitness, 0.0, gene_pool, 2, selection, termination);
+    REQUIRE(result.reason == StopReason::evaluations);
+    REQUIRE(result.evaluations == 120);  // Checked between generations.
+  }
+
+  SECTION("stagnation") {
+    Termination termination;
+    termination.max_stagnation = 5;
+    GAResult<state> result = evolve<state>(copies, fitness, 0.0, gene_pool, 2, selection, termination);
+    REQUIRE(result.reason == StopReason::stagnation);
+    REQUIRE(result.generations == 5);
+    REQUIRE(result.best == copies[0]);
+    REQUIRE(result.fitness == 26);
+  }
+
+  SECTION("time") {
+    Termination termination;
+    termination.max_seconds = 0;
+    ThreadPool pool(2);
+    GAResult<state> result = parallel_evolve<state>(copies, fitness, 0.0, gene_pool, 2, pool, 1, selection, termination);
+    REQUIRE(result.reason == StopReason::time);
+    REQUIRE(result.generations == 0);
+  }
+
+  SECTION("statistics") {
+    GAResult<state> result;
+    state best = genectic_algoritm<state>(population, fitness, 0.1, gene_pool, 2, selection, {}, &result);
+    REQUIRE(result.best == best);
+    REQUIRE(result.evaluations == 50 * uint64_t(result.generations + 1));
+    if(stats_enabled) {
+      REQUIRE(result.phases["initialize"] > 0);
+      REQUIRE((result.generations == 0 || result.phases["breeding"] > 0));
+    }
+    std::string json = to_json(result);
+    REQUIRE(json.find("\"reason\":\"" + std::string(to_string(result.reason)) + "\"") != std::string::npos);
+    REQUIRE(json.find("\"generations\":" + std::to_string(result.generations)) != std::string::npos);
+  }
+}
+
+TEST_CASE("random streams") {
+  Random a(1), b(1), c(2);
+  for(int k = 0; k < 100; k++) {
+    uint64_t x = a();
+    REQUIRE(x == b());
+    REQUIRE(x != c());
+  }
+
+  // Split streams are reproducible and differ from their parent.
+  Random root(5), again(5);
+  Random first = root.split(), second = root.split();
+  REQUIRE(first() == again.split()());
+  REQUIRE(first() != second());
+
+  vector<int> counts(6);
+  for(int k = 0; k < 60000; k++) counts[a.below(6)]++;
+  for(int count : counts) REQUIRE(count == Approx(10000).margin(500));
+
+  for(int k = 0; k < 1000; k++) {
+    double x = a.uniform();
+    REQUIRE(x >= 0);
+    REQUIRE(x < 1);
+  }
+  REQUIRE_FALSE(a.chance(0));
+  REQUIRE(a.chance(1));
+
+  seed_thread_random(3);
+  vector<state> population = generateRandomPopulation<state>(5, 8);
+  seed_thread_random(3);
+  REQUIRE(generateRandomPopulation<state>(5, 8) == population);
+}
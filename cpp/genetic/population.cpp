@@ -0,0 +1,140 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+#include "../random.cpp"
+
+// ---------------------------------------------------------------------------------
+// Flat populations
+
+/*
+ * View of the genes of one individual: a pointer into a population and a length.
+ * Indexable and iterable like the vector it stands for, so fitness functions and
+ * evaluators written for vectors take it as well.
+ */
+template <typename Gene>
+struct GeneSpan {
+  Gene& operator[](size_t i) const {
+    return data[i];
+  }
+
+  size_t size() const {
+    return length;
+  }
+
+  Gene* begin() const {
+    return data;
+  }
+
+  Gene* end() const {
+    return data + length;
+  }
+
+  Gene* data;
+  size_t length;
+};
+
+/*
+ * Individuals of the same length, stored back to back in one gene buffer
+ * (structure of arrays: individual i is genes [i * length, (i + 1) * length)).
+ *
+ * The genetic algorithm keeps two of them, the current generation and the next
+ * one, and swaps them after each generation, so breeding never allocates.
+ */
+template <typename Gene = uint16_t>
+struct Population {
+  Population() = default;
+
+  Population(size_t individuals, size_t length)
+  : individuals{ individuals }, length{ length }, genes(individuals * length) {}
+
+  /*
+   * Copies a population of vectors. Throws invalid_argument if the individuals
+   * differ in length or a gene does not fit in Gene.
+   */
+  template <typename S>
+  explicit Population(const std::vector<S>& population)
+  : Population(population.size(), population.empty() ? 0 : population[0].size()) {
+    for (size_t i = 0; i < individuals; i++) {
+      if (population[i].size() != length) {
+        throw std::invalid_argument{ "Individuals must have the same length" };
+      }
+      std::transform(population[i].begin(), population[i].end(), (*this)[i].begin(), to_gene<typename S::value_type>);
+    }
+  }
+
+  /*
+   * Converts a gene, throwing invalid_argument if it does not fit in Gene.
+   */
+  template <typename T>
+  static Gene to_gene(T value) {
+    if (value < T(0) || uint64_t(value) > std::numeric_limits<Gene>::max()) {
+      throw std::invalid_argument{ "Gene out of range" };
+    }
+    return Gene(value);
+  }
+
+  GeneSpan<Gene> operator[](size_t i) {
+    return { genes.data() + i * length, length };
+  }
+
+  GeneSpan<const Gene> operator[](size_t i) const {
+    return { genes.data() + i * length, length };
+  }
+
+  /*
+   * Copy of individual i as an S.
+   */
+  template <typename S>
+  S individual(size_t i) const {
+    GeneSpan<const Gene> genes_of = (*this)[i];
+    return S(genes_of.begin(), genes_of.end());
+  }
+
+  size_t size() const {
+    return individuals;
+  }
+
+  void swap(Population& other) {
+    std::swap(individuals, other.individuals);
+    std::swap(length, other.length);
+    genes.swap(other.genes);
+  }
+
+  size_t individuals = 0;
+  size_t length = 0;
+  std::vector<Gene> genes;
+};
+
+/*
+ * One-point crossover into child: the genes of parent1 before a random cut, then
+ * those of parent2. Makes the same draw as reproduce().
+ */
+template <typename Parent, typename Gene>
+void crossover(const Parent& parent1, const Parent& parent2, GeneSpan<Gene> child, Random& rng) {
+  size_t n = rng.below(parent1.size());
+  std::copy(parent1.begin(), parent1.begin() + n, child.begin());
+  std::copy(parent2.begin() + n, parent2.end(), child.begin() + n);
+}
+
+/*
+ * Mutates child in place, as mutate() does with the same draws. Returns the
+ * position of the changed gene.
+ */
+template <typename Gene, typename Pool>
+size_t mutate_in_place(GeneSpan<Gene> child, const Pool& gene_pool, Random& rng) {
+  size_t n = rng.below(child.size());
+  size_t gene = rng.below(gene_pool.size());
+
+  if (child[n] == gene_pool[gene]) {
+    gene = (gene + 1) % gene_pool.size();
+  }
+
+  child[n] = gene_pool[gene];
+  return n;
+}
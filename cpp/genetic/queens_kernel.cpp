@@ -0,0 +1,143 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define QUEENS_KERNEL_X86 1
+#include <immintrin.h>
+#endif
+
+#include "population.cpp"
+
+// ---------------------------------------------------------------------------------
+// N-Queens collision kernels
+
+/*
+ * Collision counting of fitness_fn over 16-bit genes: queens i and i + d attack
+ * each other iff their genes differ by 0 or d. For every distance d the kernels
+ * compare genes [0, n - d) with genes [d, n) a whole vector at a time, so the
+ * count is the same as fitness_fn's, pair by pair.
+ *
+ * The vector kernels subtract genes in 16-bit lanes, so they need genes below
+ * 2^15; queens_collisions falls back to the scalar kernel otherwise.
+ */
+enum class QueensKernel { scalar, sse2, avx2 };
+
+inline int queens_collisions_scalar(const uint16_t* genes, size_t n) {
+  int collisions = 0;
+  for (size_t d = 1; d < n; d++) {
+    for (size_t i = 0; i + d < n; i++) {
+      int difference = std::abs(int(genes[i + d]) - int(genes[i]));
+      collisions += difference == 0 || difference == int(d);
+    }
+  }
+  return collisions;
+}
+
+#ifdef QUEENS_KERNEL_X86
+
+inline int queens_collisions_sse2(const uint16_t* genes, size_t n) {
+  int collisions = 0;
+  for (size_t d = 1; d < n; d++) {
+    __m128i zero = _mm_setzero_si128();
+    __m128i plus = _mm_set1_epi16(short(d));
+    __m128i minus = _mm_set1_epi16(short(-int(d)));
+    size_t i = 0;
+    for (; i + 8 + d <= n; i += 8) {
+      __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(genes + i));
+      __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(genes + i + d));
+      __m128i difference = _mm_sub_epi16(b, a);
+      __m128i hit = _mm_or_si128(_mm_cmpeq_epi16(difference, zero),
+                    _mm_or_si128(_mm_cmpeq_epi16(difference, plus), _mm_cmpeq_epi16(difference, minus)));
+      collisions += __builtin_popcount(_mm_movemask_epi8(hit)) / 2;  // Two mask bits per lane.
+    }
+    for (; i + d < n; i++) {
+      int difference = std::abs(int(genes[i + d]) - int(genes[i]));
+      collisions += difference == 0 || difference == int(d);
+    }
+  }
+  return collisions;
+}
+
+__attribute__((target("avx2")))
+inline int queens_collisions_avx2(const uint16_t* genes, size_t n) {
+  int collisions = 0;
+  for (size_t d = 1; d < n; d++) {
+    __m256i zero = _mm256_setzero_si256();
+    __m256i distance = _mm256_set1_epi16(short(d));
+    size_t i = 0;
+    for (; i + 16 + d <= n; i += 16) {
+      __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(genes + i));
+      __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(genes + i + d));
+      __m256i difference = _mm256_abs_epi16(_mm256_sub_epi16(b, a));
+      __m256i hit = _mm256_or_si256(_mm256_cmpeq_epi16(difference, zero), _mm256_cmpeq_epi16(difference, distance));
+      collisions += __builtin_popcount(_mm256_movemask_epi8(hit)) / 2;
+    }
+    for (; i + d < n; i++) {
+      int difference = std::abs(int(genes[i + d]) - int(genes[i]));
+      collisions += difference == 0 || difference == int(d);
+    }
+  }
+  return collisions;
+}
+
+#endif
+
+/*
+ * The fastest kernel this CPU runs, detected once.
+ */
+inline QueensKernel best_queens_kernel() {
+#ifdef QUEENS_KERNEL_X86
+  static const QueensKernel best = __builtin_cpu_supports("avx2") ? QueensKernel::avx2
+                                 : __builtin_cpu_supports("sse2") ? QueensKernel::sse2
+                                 : QueensKernel::scalar;
+  return best;
+#else
+  return QueensKernel::scalar;
+#endif
+}
+
+inline bool queens_kernel_supported(QueensKernel kernel) {
+#ifdef QUEENS_KERNEL_X86
+  return kernel == QueensKernel::scalar || kernel == QueensKernel::sse2 || __builtin_cpu_supports("avx2");
+#else
+  return kernel == QueensKernel::scalar;
+#endif
+}
+
+/*
+ * Number of attacking pairs among the n queens of genes, with the given kernel
+ * (which the CPU must support, see queens_kernel_supported).
+ */
+inline int queens_collisions(const uint16_t* genes, size_t n, QueensKernel kernel = best_queens_kernel()) {
+#ifdef QUEENS_KERNEL_X86
+  bool fits = true;
+  for (size_t i = 0; i < n; i++) {
+    fits &= genes[i] < 0x8000;
+  }
+  if (fits && kernel == QueensKernel::avx2) return queens_collisions_avx2(genes, n);
+  if (fits && kernel == QueensKernel::sse2) return queens_collisions_sse2(genes, n);
+#endif
+  return queens_collisions_scalar(genes, n);
+}
+
+/*
+ * fitness_fn of a board: non-attacking pairs of queens.
+ */
+inline int queens_fitness(const uint16_t* genes, size_t n, QueensKernel kernel = best_queens_kernel()) {
+  int size = int(n);
+  return int(size * ((size - 1) / 2.0)) - queens_collisions(genes, n, kernel);
+}
+
+/*
+ * Fitness of every board of population, in order, into fitness.
+ */
+inline void queens_fitness_batch(const Population<uint16_t>& population, std::vector<int>& fitness, QueensKernel kernel = best_queens_kernel()) {
+  fitness.resize(population.size());
+  for (size_t i = 0; i < population.size(); i++) {
+    fitness[i] = queens_fitness(population[i].data, population.length, kernel);
+  }
+}
@@ -0,0 +1,49 @@
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+#include "genetic.cpp"
+
+/*
+ * Microbenchmark of the N-Queens fitness: fitness_fn against every collision
+ * kernel this CPU supports, on batches of random boards.
+ *
+ *   g++ -std=c++17 -O2 -pthread queens_kernel_benchmark.cpp && ./a.out
+ */
+
+template<typename F>
+double nanoseconds_per_board(size_t boards, F score) {
+  long long checksum = 0;
+  auto start = std::chrono::steady_clock::now();
+  for(size_t i = 0; i < boards; i++) checksum += score(i);
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  if(checksum == -1) printf("\n");  // Keeps the scores alive.
+  return seconds * 1e9 / boards;
+}
+
+int main() {
+  const char* names[] = {"scalar", "sse2", "avx2"};
+  std::mt19937 rng(1);
+
+  printf("%6s %12s %12s %12s %12s\n", "n", "fitness_fn", names[0], names[1], names[2]);
+  for(int n : {8, 16, 32, 64, 128, 512}) {
+    size_t boards = std::max(1000, 20000000 / (n * n));
+    vector<vector<int>> individuals(boards, vector<int>(n));
+    for(auto& individual : individuals) {
+      for(int& gene : individual) gene = rng() % n;
+    }
+    Population<uint16_t> population(individuals);
+
+    printf("%6d %12.1f", n, nanoseconds_per_board(boards, [&](size_t i) { return fitness_fn(individuals[i]); }));
+    for(QueensKernel kernel : {QueensKernel::scalar, QueensKernel::sse2, QueensKernel::avx2}) {
+      if(!queens_kernel_supported(kernel)) {
+        printf(" %12s", "-");
+        continue;
+      }
+      printf(" %12.1f", nanoseconds_per_board(boards, [&](size_t i) {
+        return queens_fitness(population[i].data, population.length, kernel);
+      }));
+    }
+    printf("   ns/board\n");
+  }
+}
@@ -0,0 +1,147 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <numeric>
+#include <vector>
+
+#include "../random.cpp"
+
+// ---------------------------------------------------------------------------------
+// Parent selection
+
+/*
+ * A selection scheme is prepared once per generation with the weights (fitness)
+ * of the population, and then draws the index of a parent with operator()(rng).
+ * Draws are independent of each other, and const, so threads may draw from the
+ * same prepared scheme with their own streams (see Random).
+ */
+
+/*
+ * Fitness-proportional selection: binary search over the prefix sums of the
+ * weights, O(log P) per draw. Uniform when every weight is 0.
+ */
+struct RouletteSelection {
+  void prepare(const std::vector<int>& weights) {
+    cumulative.resize(weights.size());
+    double total = 0;
+    for (size_t i = 0; i < weights.size(); i++) {
+      total += std::max(weights[i], 0);
+      cumulative[i] = total;
+    }
+  }
+
+  size_t operator()(Random& rng) const {
+    double total = cumulative.back();
+    if (total <= 0) {
+      return rng.below(cumulative.size());
+    }
+    double target = rng.uniform() * total;
+    size_t i = std::upper_bound(cumulative.begin(), cumulative.end(), target) - cumulative.begin();
+    return std::min(i, cumulative.size() - 1);
+  }
+
+  std::vector<double> cumulative;
+};
+
+/*
+ * Fitness-proportional selection with Walker's alias method (Vose's
+ * construction): O(P) to prepare, O(1) per draw. Uniform when every weight is 0.
+ */
+struct AliasSelection {
+  void prepare(const std::vector<int>& weights) {
+    size_t n = weights.size();
+    double total = 0;
+    for (int weight : weights) {
+      total += std::max(weight, 0);
+    }
+
+    probability.resize(n);
+    alias.resize(n);
+    small.clear();
+    large.clear();
+    for (size_t i = 0; i < n; i++) {
+      probability[i] = total > 0 ? std::max(weights[i], 0) * n / total : 1;
+      alias[i] = i;
+      (probability[i] < 1 ? small : large).push_back(i);
+    }
+
+    while (!small.empty() && !large.empty()) {
+      size_t less = small.back();
+      size_t more = large.back();
+      small.pop_back();
+      alias[less] = more;
+      probability[more] -= 1 - probability[less];
+      if (probability[more] < 1) {
+        large.pop_back();
+        small.push_back(more);
+      }
+    }
+    for (size_t i : small) probability[i] = 1;  // Rounding leftovers.
+    for (size_t i : large) probability[i] = 1;
+  }
+
+  size_t operator()(Random& rng) const {
+    size_t i = rng.below(probability.size());
+    return rng.uniform() < probability[i] ? i : alias[i];
+  }
+
+  std::vector<double> probability;  // Of keeping column i rather than its alias.
+  std::vector<size_t> alias;
+
+private:
+  std::vector<size_t> small, large;  // Work lists, kept to reuse their memory.
+};
+
+/*
+ * Tournament selection: the fittest of size individuals drawn uniformly. Larger
+ * tournaments mean stronger selection pressure.
+ */
+struct TournamentSelection {
+  void prepare(const std::vector<int>& weights) {
+    this->weights = &weights;
+  }
+
+  size_t operator()(Random& rng) const {
+    size_t best = rng.below(weights->size());
+    for (int k = 1; k < size; k++) {
+      size_t other = rng.below(weights->size());
+      if ((*weights)[other] > (*weights)[best]) {
+        best = other;
+      }
+    }
+    return best;
+  }
+
+  int size = 2;
+  const std::vector<int>* weights = nullptr;  // Of the prepared generation.
+};
+
+/*
+ * Linear rank selection: the weight of an individual is its rank by fitness (1
+ * for the least fit, P for the fittest), so selection pressure does not depend
+ * on the scale of the fitness. Ties share the rank of the first of them.
+ */
+struct RankSelection {
+  void prepare(const std::vector<int>& weights) {
+    order.resize(weights.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return weights[a] < weights[b]; });
+
+    ranks.resize(weights.size());
+    for (size_t k = 0; k < order.size(); k++) {
+      bool tie = k > 0 && weights[order[k]] == weights[order[k - 1]];
+      ranks[order[k]] = tie ? ranks[order[k - 1]] : int(k + 1);
+    }
+    roulette.prepare(ranks);
+  }
+
+  size_t operator()(Random& rng) const {
+    return roulette(rng);
+  }
+
+private:
+  std::vector<size_t> order;
+  std::vector<int> ranks;
+  AliasSelection roulette;
+};
@@ -0,0 +1,278 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "../search.cpp"
+#include "../concurrency.cpp"
+
+// ---------------------------------------------------------------------------------
+// Search algorithms: Hash-Distributed A*
+
+/*
+ * What an HDA* run found, and how much work each thread did.
+ */
+template <typename S, typename A>
+struct HDAStarResult {
+  size_t expanded() const {
+    size_t total = 0;
+    for (size_t count : expanded_by_thread) {
+      total += count;
+    }
+    return total;
+  }
+
+  bool found = false;
+  double cost = 0;
+  std::vector<A> actions;  // From the initial state to the goal.
+  std::vector<size_t> expanded_by_thread;
+  double seconds = 0;
+};
+
+/*
+ * Parallel A* where every state has an owner thread, chosen by the hash of its
+ * packed key. Each thread keeps the open and closed lists of the states it owns;
+ * a generated child owned by another thread is sent to it through that thread's
+ * lock-free inbox, in batches.
+ *
+ * A goal only sets an upper bound (the incumbent) on the solution cost. Threads
+ * keep expanding nodes with f below the incumbent, reopening closed states that
+ * arrive with a cheaper path, so the result is optimal with an admissible
+ * heuristic. The search ends once every thread is idle and no batch is in flight.
+ */
+template <typename P, typename Packer = packer_of_t<P>>
+struct HDAStar {
+  using S = typename P::state_type;
+  using A = typename P::action_type;
+
+  HDAStar(const P& problem, int threads, Packer pack = {})
+  : problem{ problem }, pack{ pack }, workers(std::max(threads, 1)) {
+    for (auto& worker : workers) {
+      worker = std::make_unique<Worker>();
+    }
+  }
+
+  HDAStarResult<S, A> search() {
+    auto start = std::chrono::steady_clock::now();
+    Message root{ problem.initial, A{}, 0.0, no_parent };
+    workers[owner(problem.initial)]->inbox.push({ root });
+    in_flight = 1;
+    sent = 1;
+
+    std::vector<std::thread> threads;
+    for (size_t id = 0; id < workers.size(); id++) {
+      threads.emplace_back([this, id] { run(id); });
+    }
+    for (std::thread& thread : threads) {
+      thread.join();
+    }
+
+    HDAStarResult<S, A> result;
+    for (const auto& worker : workers) {
+      result.expanded_by_thread.push_back(worker->expanded);
+    }
+    if (goal != no_parent) {
+      result.found = true;
+      result.cost = incumbent;
+      for (uint64_t ref = goal; node(ref).parent != no_parent; ref = node(ref).parent) {
+        result.actions.push_back(node(ref).action);
+      }
+      std::reverse(result.actions.begin(), result.actions.end());
+    }
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return result;
+  }
+
+private:
+  static constexpr uint64_t no_parent = std::numeric_limits<uint64_t>::max();
+  static constexpr size_t expansions_per_round = 64;
+
+  /*
+   * A node, in the table of its owner. parent is (worker << 32) | index.
+   */
+  struct HDANode {
+    S state;
+    A action;
+    double g;
+    uint64_t parent;
+  };
+
+  /*
+   * A generated state, on its way to its owner.
+   */
+  struct Message {
+    S state;
+    A action;
+    double g;
+    uint64_t parent;
+  };
+
+  struct Worker {
+    std::deque<HDANode> nodes;  // Never moves its elements.
+    IndexedHeap<> open;
+    ReachedTable<typename Packer::key_type, typename Packer::hasher> reached;
+    MpscQueue<std::vector<Message>> inbox;
+    std::atomic<bool> idle{ false };
+    size_t expanded = 0;
+  };
+
+  /*
+   * The thread that owns state. ReachedTable starts probing at the low bits of
+   * the same mixed hash, so the owner is taken from the high ones: keys owned by
+   * one thread still start anywhere in its table.
+   */
+  size_t owner(const S& state) const {
+    return (mix_hash(typename Packer::hasher{}(pack(state))) >> 32) % workers.size();
+  }
+
+  HDANode& node(uint64_t ref) {
+    return workers[ref >> 32]->nodes[ref & 0xFFFFFFFF];
+  }
+
+  void run(size_t id) {
+    Worker& self = *workers[id];
+    std::vector<std::vector<Message>> outbox(workers.size());
+    std::vector<Message> batch;
+
+    while (!done.load()) {
+      bool received = false;
+      while (self.inbox.pop(batch)) {
+        self.idle = false;  // Before in_flight drops, see quiescent().
+        for (Message& message : batch) {
+          receive(self, message);
+        }
+        in_flight--;
+        received = true;
+      }
+
+      size_t expansions = 0;
+      while (self.open && self.open.top_key() < incumbent.load() && expansions++ < expansions_per_round) {
+        expand(id, self, outbox);
+      }
+
+      for (size_t to = 0; to < workers.size(); to++) {
+        if (!outbox[to].empty()) {
+          in_flight++;
+          sent++;
+          workers[to]->inbox.push(std::move(outbox[to]));
+          outbox[to] = {};
+        }
+      }
+
+      if (expansions == 0 && !received) {
+        self.idle = true;
+        if (quiescent()) {
+          done = true;
+        } else {
+          std::this_thread::yield();
+        }
+      }
+    }
+  }
+
+  /*
+   * Adds a state to the owner's open list, unless it is already there (or
+   * closed) with a path at most as cheap.
+   */
+  void receive(Worker& self, const Message& message) {
+    double f = message.g + problem.h(message.state);
+    if (f >= incumbent.load()) {
+      return;
+    }
+
+    NodeIndex& found = self.reached.find_or_insert(pack(message.state));
+    if (found == no_node) {
+      found = static_cast<NodeIndex>(self.nodes.size());
+      self.nodes.push_back(HDANode{ message.state, message.action, message.g, message.parent });
+      self.open.push(found, f);
+      return;
+    }
+
+    HDANode& existing = self.nodes[found];
+    if (message.g < existing.g) {
+      existing.action = message.action;
+      existing.g = message.g;
+      existing.parent = message.parent;
+      if (self.open.contains(found)) {
+        self.open.decrease_key(found, f);
+      } else {
+        self.open.push(found, f);  // Reopened.
+      }
+    }
+  }
+
+  void expand(size_t id, Worker& self, std::vector<std::vector<Message>>& outbox) {
+    NodeIndex index = self.open.pop();
+    const HDANode& current = self.nodes[index];
+    uint64_t ref = (uint64_t(id) << 32) | index;
+
+    if (problem.is_goal(current.state)) {
+      std::lock_guard<std::mutex> lock{ goal_mutex };
+      if (current.g < incumbent.load()) {
+        incumbent = current.g;
+        goal = ref;
+      }
+      return;
+    }
+
+    self.expanded++;
+    double g = current.g;
+    problem.successors(current.state, [&](const A& action, const S& child, double step_cost) {
+      Message message{ child, action, g + step_cost, ref };
+      size_t to = owner(child);
+      if (to == id) {
+        receive(self, message);
+      } else {
+        outbox[to].push_back(message);
+      }
+    });
+  }
+
+  /*
+   * True when no thread has work left and nothing is in flight. Sent batches are
+   * counted before being pushed and receivers mark themselves busy before
+   * uncounting them, so a stable sent counter around a scan that finds every
+   * thread idle means that no work can appear anymore.
+   */
+  bool quiescent() const {
+    uint64_t sent_before = sent.load();
+    if (in_flight.load() != 0) {
+      return false;
+    }
+    for (const auto& worker : workers) {
+      if (!worker->idle.load()) {
+        return false;
+      }
+    }
+    return in_flight.load() == 0 && sent.load() == sent_before;
+  }
+
+  const P& problem;
+  Packer pack;
+  std::vector<std::unique_ptr<Worker>> workers;
+
+  std::atomic<double> incumbent{ std::numeric_limits<double>::infinity() };
+  uint64_t goal = no_parent;
+  std::mutex goal_mutex;
+
+  std::atomic<int64_t> in_flight{ 0 };
+  std::atomic<uint64_t> sent{ 0 };
+  std::atomic<bool> done{ false };
+};
+
+template <typename P, typename Packer = packer_of_t<P>>
+HDAStarResult<typename P::state_type, typename P::action_type> hda_star_search(
+  const P& problem,
+  int threads = std::thread::hardware_concurrency(),
+  Packer pack = {}
+) {
+  return HDAStar<P, Packer>{ problem, threads, pack }.search();
+}
@@ -0,0 +1,85 @@
+#define CATCH_CONFIG_MAIN
+#include "../catch.hpp"
+#include "../sliding-tile/sliding_tile.cpp"
+#include "hda_star.cpp"
+
+#include <string>
+
+TEST_CASE("MPSC queue keeps each producer's order") {
+  MpscQueue<int> queue;
+  std::vector<std::thread> producers;
+  for (int p = 0; p < 4; p++) {
+    producers.emplace_back([&queue, p] {
+      for (int i = 0; i < 1000; i++) {
+        queue.push(p * 1000 + i);
+      }
+    });
+  }
+
+  std::vector<int> last(4, -1);
+  int received = 0;
+  while (received < 4000) {
+    int value;
+    if (queue.pop(value)) {
+      REQUIRE(value % 1000 > last[value / 1000]);
+      last[value / 1000] = value % 1000;
+      received++;
+    }
+  }
+  for (std::thread& producer : producers) {
+    producer.join();
+  }
+  int value;
+  REQUIRE(!queue.pop(value));
+}
+
+TEST_CASE("HDA* finds optimal 8 Puzzle solutions on any number of threads") {
+  Matrix initial = {{
+    {8, 6, 7},
+    {2, 5, 4},
+    {3, 0, 1}
+  }};
+
+  Matrix goal = {{
+    {1, 2, 3},
+    {4, 5, 6},
+    {7, 8, 0}
+  }};
+
+  EightPuzzle<Matrix, Actions> eightPuzzle(initial, goal);
+
+  for (int threads : { 1, 2, 4 }) {
+    SECTION(std::to_string(threads) + " threads") {
+      auto result = hda_star_search(eightPuzzle, threads);
+      REQUIRE(result.found);
+      REQUIRE(result.cost == Approx(31));
+      REQUIRE(result.expanded_by_thread.size() == size_t(threads));
+
+      Matrix state = initial;
+      for (Actions action : result.actions) {
+        state = eightPuzzle.result(state, action);
+      }
+      REQUIRE(state == goal);
+    }
+  }
+}
+
+TEST_CASE("HDA* matches A* on 15 Puzzle instances") {
+  std::array<int, 16> goal = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 0 };
+  SlidingTile<4, 4> puzzle{ { 5, 1, 2, 4, 9, 6, 3, 8, 13, 10, 7, 11, 0, 14, 15, 12 }, goal };
+  NodeArena<TileState<4, 4>, Actions> arena;
+  NodeIndex optimal = astar_search(puzzle, arena);
+
+  auto result = hda_star_search(puzzle, 4);
+  REQUIRE(result.found);
+  REQUIRE(result.cost == Approx(arena[optimal].path_cost));
+  REQUIRE(result.actions.size() == result.cost);
+}
+
+TEST_CASE("HDA* terminates without a solution") {
+  SlidingTile<3, 2> puzzle{ { 2, 1, 3, 4, 5, 0 }, { 1, 2, 3, 4, 5, 0 } };
+
+  auto result = hda_star_search(puzzle, 3);
+  REQUIRE(!result.found);
+  REQUIRE(result.expanded() >= 360);  // Every state of the unsolvable half of the 5 Puzzle.
+}
@@ -0,0 +1,205 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <limits>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "../search.cpp"
+
+// ---------------------------------------------------------------------------------
+// Search algorithms: Iterative-Deepening A*
+
+/*
+ * What an IDA* run found, and how much work it took.
+ */
+template <typename S, typename A>
+struct IDAStarResult {
+  double nodes_per_second() const {
+    return seconds > 0 ? nodes / seconds : 0;
+  }
+
+  bool found = false;
+  double cost = 0;
+  std::vector<A> actions;  // From the initial state to the goal.
+  size_t nodes = 0;        // Nodes generated, over every iteration.
+  int iterations = 0;
+  double seconds = 0;
+};
+
+/*
+ * True when P can move in place: for_each_action(state, visit), apply(state&,
+ * action) returning the step cost, undo(state&, action) and inverse(action), as
+ * SlidingTile does.
+ */
+template <typename P, typename = void>
+struct moves_in_place : std::false_type {};
+
+template <typename P>
+struct moves_in_place<P, std::void_t<
+  decltype(std::declval<const P&>().for_each_action(std::declval<const typename P::state_type&>(), std::declval<void (*)(typename P::action_type)>())),
+  decltype(std::declval<const P&>().apply(std::declval<typename P::state_type&>(), std::declval<typename P::action_type>())),
+  decltype(std::declval<const P&>().undo(std::declval<typename P::state_type&>(), std::declval<typename P::action_type>())),
+  decltype(P::inverse(std::declval<typename P::action_type>()))
+>> : std::true_type {};
+
+/*
+ * True when P can tell whether a state reaches the goal: is_solvable(state) as
+ * SlidingTile has, or check_solvability(state) as EightPuzzle has.
+ */
+template <typename P, typename = void>
+struct has_is_solvable : std::false_type {};
+
+template <typename P>
+struct has_is_solvable<P, std::void_t<
+  decltype(bool(std::declval<const P&>().is_solvable(std::declval<const typename P::state_type&>())))
+>> : std::true_type {};
+
+template <typename P, typename = void>
+struct has_check_solvability : std::false_type {};
+
+template <typename P>
+struct has_check_solvability<P, std::void_t<
+  decltype(bool(std::declval<const P&>().check_solvability(std::declval<const typename P::state_type&>())))
+>> : std::true_type {};
+
+/*
+ * False only when P knows that state cannot reach the goal.
+ */
+template <typename P>
+bool may_reach_goal(const P& problem, const typename P::state_type& state) {
+  if constexpr (has_is_solvable<P>::value) {
+    return problem.is_solvable(state);
+  } else if constexpr (has_check_solvability<P>::value) {
+    return problem.check_solvability(state);
+  } else {
+    return true;
+  }
+}
+
+/*
+ * Depth-first searches bounded by f = g + h, raising the bound to the smallest f
+ * that exceeded it until a goal is found.
+ *
+ * Memory is linear in the depth of the solution: no reached set, no frontier.
+ * Problems that move in place (see moves_in_place) mutate a single state and undo
+ * each move on the way back; the others go through successors(), with each child
+ * living in its caller's stack frame. Moving straight back to the parent state is
+ * pruned. Gives up once the bound goes over max_bound.
+ *
+ * The bounds of an unsolvable instance rise forever, so problems that can tell
+ * (see may_reach_goal) are checked first and return no solution at once; for
+ * the others, only max_bound stops such a search.
+ */
+template <typename P>
+struct IDAStar {
+  using S = typename P::state_type;
+  using A = typename P::action_type;
+
+  IDAStar(const P& problem, double max_bound = std::numeric_limits<double>::infinity())
+  : problem{ problem }, max_bound{ max_bound } {}
+
+  IDAStarResult<S, A> search() {
+    auto start = std::chrono::steady_clock::now();
+    result = IDAStarResult<S, A>{};
+    path.clear();
+    S state = problem.initial;
+    double bound = problem.h(state);
+    bool solvable = may_reach_goal(problem, state);
+
+    while (solvable && bound <= max_bound) {
+      result.iterations++;
+      double next_bound;
+      if constexpr (moves_in_place<P>::value) {
+        next_bound = search_in_place(state, 0, bound);
+      } else {
+        next_bound = search_copying(state, nullptr, 0, bound);
+      }
+      if (result.found || next_bound == std::numeric_limits<double>::infinity()) {
+        break;
+      }
+      bound = next_bound;
+    }
+
+    result.actions = path;
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return result;
+  }
+
+private:
+  /*
+   * Returns the cost of the goal if found, or the smallest f over the bound.
+   */
+  double search_in_place(S& state, double g, double bound) {
+    double f = g + problem.h(state);
+    if (f > bound) {
+      return f;
+    }
+    if (problem.is_goal(state)) {
+      result.found = true;
+      result.cost = g;
+      return g;
+    }
+
+    double next_bound = std::numeric_limits<double>::infinity();
+    problem.for_each_action(state, [&](A action) {
+      if (result.found || (!path.empty() && action == P::inverse(path.back()))) {
+        return;
+      }
+      double cost = problem.apply(state, action);
+      result.nodes++;
+      path.push_back(action);
+      double t = search_in_place(state, g + cost, bound);
+      if (result.found) {
+        return;
+      }
+      path.pop_back();
+      problem.undo(state, action);
+      next_bound = std::min(next_bound, t);
+    });
+    return next_bound;
+  }
+
+  double search_copying(const S& state, const S* parent, double g, double bound) {
+    double f = g + problem.h(state);
+    if (f > bound) {
+      return f;
+    }
+    if (problem.is_goal(state)) {
+      result.found = true;
+      result.cost = g;
+      return g;
+    }
+
+    double next_bound = std::numeric_limits<double>::infinity();
+    problem.successors(state, [&](const A& action, const S& child, double cost) {
+      if (result.found || (parent && child == *parent)) {
+        return;
+      }
+      result.nodes++;
+      path.push_back(action);
+      double t = search_copying(child, &state, g + cost, bound);
+      if (result.found) {
+        return;
+      }
+      path.pop_back();
+      next_bound = std::min(next_bound, t);
+    });
+    return next_bound;
+  }
+
+  const P& problem;
+  double max_bound;
+  IDAStarResult<S, A> result;
+  std::vector<A> path;
+};
+
+template <typename P>
+IDAStarResult<typename P::state_type, typename P::action_type> ida_star_search(
+  const P& problem,
+  double max_bound = std::numeric_limits<double>::infinity()
+) {
+  return IDAStar<P>{ problem, max_bound }.search();
+}
@@ -0,0 +1,93 @@
+#define CATCH_CONFIG_MAIN
+#include "../catch.hpp"
+#include "../sliding-tile/sliding_tile.cpp"
+#include "ida_star.cpp"
+
+TEST_CASE("IDA* moves sliding tiles in place") {
+  REQUIRE(moves_in_place<SlidingTile<3, 3>>::value);
+  REQUIRE(!moves_in_place<EightPuzzle<Matrix, Actions>>::value);
+}
+
+TEST_CASE("IDA* finds optimal 8 Puzzle solutions") {
+  SlidingTile<3, 3> puzzle{ { 8, 6, 7, 2, 5, 4, 3, 0, 1 }, { 1, 2, 3, 4, 5, 6, 7, 8, 0 } };
+
+  auto result = ida_star_search(puzzle);
+  REQUIRE(result.found);
+  REQUIRE(result.cost == Approx(31));
+  REQUIRE(result.actions.size() == 31);
+  REQUIRE(result.nodes > 0);
+  REQUIRE(result.nodes_per_second() > 0);
+
+  TileState<3, 3> state = puzzle.initial;
+  for (Actions action : result.actions) {
+    puzzle.apply(state, action);
+  }
+  REQUIRE(puzzle.is_goal(state));
+}
+
+TEST_CASE("IDA* works through successors for other problems") {
+  Matrix initial = {{
+    {7, 2, 4},
+    {5, 0, 6},
+    {8, 3, 1}
+  }};
+
+  Matrix goal = {{
+    {0, 1, 2},
+    {3, 4, 5},
+    {6, 7, 8}
+  }};
+
+  EightPuzzle<Matrix, Actions> eightPuzzle(initial, goal);
+  NodeArena<Matrix, Actions> arena;
+  NodeIndex optimal = astar_search(eightPuzzle, arena);
+
+  auto result = ida_star_search(eightPuzzle);
+  REQUIRE(result.found);
+  REQUIRE(result.cost == Approx(arena[optimal].path_cost));
+
+  Matrix state = initial;
+  for (Actions action : result.actions) {
+    state = eightPuzzle.result(state, action);
+  }
+  REQUIRE(state == goal);
+}
+
+TEST_CASE("IDA* solves 15 Puzzle instances with a pattern database") {
+  std::array<int, 16> goal = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 0 };
+  SlidingTile<4, 4> puzzle{ { 5, 1, 2, 4, 9, 6, 3, 8, 13, 10, 7, 11, 0, 14, 15, 12 }, goal };
+  PatternDatabase database{
+    4, 4, std::vector<int>(goal.begin(), goal.end()),
+    { { 1, 2, 5, 6 }, { 3, 4, 7, 8 }, { 9, 10, 13, 14 }, { 11, 12, 15 } }
+  };
+  puzzle.pattern_database = &database;
+
+  auto result = ida_star_search(puzzle);
+  NodeArena<TileState<4, 4>, Actions> arena;
+  NodeIndex optimal = astar_search(puzzle, arena);
+
+  REQUIRE(result.found);
+  REQUIRE(result.cost == Approx(arena[optimal].path_cost));
+}
+
+TEST_CASE("IDA* gives up past its bound") {
+  SlidingTile<3, 3> puzzle{ { 8, 6, 7, 2, 5, 4, 3, 0, 1 }, { 1, 2, 3, 4, 5, 6, 7, 8, 0 } };
+
+  auto result = ida_star_search(puzzle, 20);
+  REQUIRE(!result.found);
+  REQUIRE(result.actions.empty());
+}
+
+TEST_CASE("IDA* returns no solution for unsolvable boards") {
+  std::array<int, 9> goal = { 0, 1, 2, 3, 4, 5, 6, 7, 8 };
+  SlidingTile<3, 3> puzzle{ { 0, 2, 1, 3, 4, 5, 6, 7, 8 }, goal };
+
+  auto result = ida_star_search(puzzle);
+  REQUIRE(!result.found);
+  REQUIRE(result.actions.empty());
+  REQUIRE(result.iterations == 0);
+
+  Matrix swapped = {{ {0, 2, 1}, {3, 4, 5}, {6, 7, 8} }};
+  EightPuzzle<Matrix, Actions> eightPuzzle(swapped, Matrix{{ {0, 1, 2}, {3, 4, 5}, {6, 7, 8} }});
+  REQUIRE(!ida_star_search(eightPuzzle).found);
+}
@@ -0,0 +1,256 @@
+#pragma once
+
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "../random.cpp"
+
+// ---------------------------------------------------------------------------------
+// Search algorithms: Monte Carlo tree search
+
+/*
+ * Games are searched through a small static interface:
+ *
+ *   using state_type, action_type;
+ *   static constexpr size_t max_actions;           // Bound on actions(state).
+ *   size_t actions(const S&, A* out) const;        // Legal actions, 0 if terminal.
+ *   void play(S&, A) const;                        // Applies an action in place.
+ *   int to_move(const S&) const;                   // Player to move.
+ *   double utility(const S&, int player) const;    // Of a terminal state, in [-1, 1].
+ */
+
+/*
+ * Node of the search tree. The children of a node are the child_count nodes
+ * starting at first_child in the arena. Nodes keep no state: it is replayed from
+ * the root while descending.
+ */
+template <typename A>
+struct MCTSNode {
+  float U = 0;       // Total reward of player, who made the move into this node.
+  float N = 0;       // Visits.
+  uint32_t parent;
+  uint32_t first_child = 0;
+  uint16_t child_count = 0;
+  bool expanded = false;
+  int8_t player;
+  A action;
+};
+
+/*
+ * UCB1 of a child: exploitation U / N plus exploration C sqrt(ln N_parent / N),
+ * with log_parent = ln N_parent computed once per level. Unvisited children come
+ * first.
+ */
+inline float ucb(float U, float N, float log_parent, float C = 1.4f) {
+  if (N == 0) {
+    return std::numeric_limits<float>::infinity();
+  }
+  return U / N + C * std::sqrt(log_parent / N);
+}
+
+/*
+ * Monte Carlo tree search: each playout selects a leaf by UCB1, expands it, plays
+ * random moves until the game ends and backs the result up the path. A win is
+ * worth 1 to the player who moved into a node, a draw 1/2.
+ *
+ * The tree lives in one arena of nodes, cleared but not freed between searches,
+ * and playouts run on a copy of the state with a fixed action buffer, so once the
+ * arena has grown a search allocates nothing.
+ */
+template <typename G>
+struct MCTS {
+  using S = typename G::state_type;
+  using A = typename G::action_type;
+  using Node = MCTSNode<A>;
+
+  explicit MCTS(const G& game, float C = 1.4f) : game{ game }, C{ C } {}
+
+  /*
+   * The most visited action of root after playouts playouts.
+   */
+  A search(const S& root, size_t playouts, Random& random = thread_random()) {
+    nodes.clear();
+    nodes.push_back(Node{ 0, 0, 0, 0, 0, false, int8_t(-1), A{} });
+
+    for (size_t i = 0; i < playouts; i++) {
+      playout(root, random);
+    }
+
+    const Node& top = nodes[0];
+    uint32_t best = top.first_child;
+    for (uint32_t child = top.first_child; child < top.first_child + top.child_count; child++) {
+      if (nodes[child].N > nodes[best].N) {
+        best = child;
+      }
+    }
+    return nodes[best].action;
+  }
+
+  std::vector<Node> nodes;  // The tree of the last search, root first.
+
+private:
+  void playout(const S& root, Random& random) {
+    S state = root;
+    uint32_t current = 0;
+    path.clear();
+    path.push_back(current);
+
+    // Selection.
+    while (nodes[current].expanded && nodes[current].child_count > 0) {
+      const Node& node = nodes[current];
+      float log_parent = std::log(node.N);
+      uint32_t best = node.first_child;
+      float best_score = -std::numeric_limits<float>::infinity();
+      for (uint32_t child = node.first_child; child < node.first_child + node.child_count; child++) {
+        float score = ucb(nodes[child].U, nodes[child].N, log_parent, C);
+        if (score > best_score) {
+          best = child;
+          best_score = score;
+        }
+      }
+      current = best;
+      game.play(state, nodes[current].action);
+      path.push_back(current);
+    }
+
+    // Expansion: every child at once, then the first one, not visited yet.
+    if (!nodes[current].expanded) {
+      size_t count = game.actions(state, buffer.data());
+      uint32_t first = static_cast<uint32_t>(nodes.size());
+      int8_t player = static_cast<int8_t>(game.to_move(state));
+      for (size_t k = 0; k < count; k++) {
+        nodes.push_back(Node{ 0, 0, current, 0, 0, false, player, buffer[k] });
+      }
+      nodes[current].expanded = true;
+      nodes[current].first_child = first;
+      nodes[current].child_count = static_cast<uint16_t>(count);
+      if (count > 0) {
+        current = first;
+        game.play(state, nodes[current].action);
+        path.push_back(current);
+      }
+    }
+
+    // Simulation.
+    for (size_t count; (count = game.actions(state, buffer.data())) > 0;) {
+      game.play(state, buffer[random.below(count)]);
+    }
+
+    // Backpropagation.
+    for (uint32_t index : path) {
+      Node& node = nodes[index];
+      node.N += 1;
+      if (node.player >= 0) {
+        node.U += (game.utility(state, node.player) + 1) / 2;
+      }
+    }
+  }
+
+  const G& game;
+  float C;
+  std::vector<uint32_t> path;
+  std::array<A, G::max_actions> buffer;
+};
+
+template <typename G>
+typename G::action_type monte_carlo_tree_search(
+  const G& game,
+  const typename G::state_type& state,
+  size_t playouts = 1000,
+  Random& random = thread_random()
+) {
+  return MCTS<G>{ game }.search(state, playouts, random);
+}
+
+// ---------------------------------------------------------------------------------
+// Games
+
+/*
+ * A position of TicTacToe: cells hold 0 (empty), 1 (X) or 2 (O), row-major.
+ */
+template <int H, int V>
+struct TicTacToeState {
+  std::array<int8_t, H * V> board{};
+  int8_t to_move = 1;
+  int8_t winner = 0;  // Player who completed a line, if any.
+  int8_t empty = H * V;
+};
+
+/*
+ * k in a row on an H x V board; X (player 1) moves first. Actions are cell
+ * indexes, row-major.
+ */
+template <int H = 3, int V = 3, int K = 3>
+struct TicTacToe {
+  using state_type = TicTacToeState<H, V>;
+  using action_type = int;
+  static constexpr size_t max_actions = H * V;
+
+  state_type initial;
+
+  /*
+   * Position with X on x_cells and O on o_cells, given as (row, col), and player
+   * to_move to move.
+   */
+  state_type position(int to_move, const std::vector<std::array<int, 2>>& x_cells, const std::vector<std::array<int, 2>>& o_cells) const {
+    state_type state;
+    for (const auto& [row, col] : x_cells) state.board[row * V + col] = 1;
+    for (const auto& [row, col] : o_cells) state.board[row * V + col] = 2;
+    state.empty = H * V - x_cells.size() - o_cells.size();
+    state.to_move = to_move;
+    return state;
+  }
+
+  size_t actions(const state_type& state, action_type* out) const {
+    if (state.winner != 0) {
+      return 0;
+    }
+    size_t count = 0;
+    for (int cell = 0; cell < H * V; cell++) {
+      if (state.board[cell] == 0) {
+        out[count++] = cell;
+      }
+    }
+    return count;
+  }
+
+  void play(state_type& state, action_type cell) const {
+    int player = state.to_move;
+    state.board[cell] = player;
+    state.empty--;
+    state.to_move = 3 - player;
+    if (k_in_row(state, cell, player, 0, 1) || k_in_row(state, cell, player, 1, 0) ||
+        k_in_row(state, cell, player, 1, -1) || k_in_row(state, cell, player, 1, 1)) {
+      state.winner = player;
+    }
+  }
+
+  int to_move(const state_type& state) const {
+    return state.to_move;
+  }
+
+  double utility(const state_type& state, int player) const {
+    return state.winner == 0 ? 0 : state.winner == player ? 1 : -1;
+  }
+
+  bool terminal_test(const state_type& state) const {
+    return state.winner != 0 || state.empty == 0;
+  }
+
+private:
+  bool k_in_row(const state_type& state, int cell, int player, int d_row, int d_col) const {
+    int n = -1;  // The cell itself is counted twice.
+    for (int sign : { 1, -1 }) {
+      int row = cell / V, col = cell % V;
+      while (row >= 0 && row < H && col >= 0 && col < V && state.board[row * V + col] == player) {
+        n++;
+        row += sign * d_row;
+        col += sign * d_col;
+      }
+    }
+    return n >= K;
+  }
+};
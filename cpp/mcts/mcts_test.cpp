@@ -0,0 +1,122 @@
+#define CATCH_CONFIG_MAIN
+#include "../catch.hpp"
+#include "mcts.cpp"
+#include "parallel_mcts.cpp"
+#include "../utils.cpp"
+
+using Game = TicTacToe<>;
+
+TEST_CASE("MCTS plays in the middle when it guarantees a win") {
+  Game game;
+  Random random{ 1 };
+  auto state = game.position(1, {{0, 0}, {2, 2}}, {{0, 1}, {2, 1}});
+  REQUIRE(monte_carlo_tree_search(game, state, 2000, random) == 4);
+}
+
+TEST_CASE("MCTS plays on either cell that wins") {
+  Game game;
+  Random random{ 2 };
+  auto state = game.position(1, {{0, 0}, {2, 2}, {2, 0}}, {{0, 1}, {2, 1}});
+  int action = monte_carlo_tree_search(game, state, 2000, random);
+  REQUIRE((action == 4 || action == 3));
+}
+
+TEST_CASE("MCTS blocks the opponent's win") {
+  Game game;
+  Random random{ 3 };
+  auto state = game.position(1, {{0, 0}}, {{0, 1}, {2, 1}});
+  REQUIRE(monte_carlo_tree_search(game, state, 5000, random) == 4);
+}
+
+TEST_CASE("MCTS self-play draws") {
+  Game game;
+  Random random{ 4 };
+  MCTS<Game> x{ game }, o{ game };
+  auto state = game.initial;
+  while (!game.terminal_test(state)) {
+    MCTS<Game>& player = state.to_move == 1 ? x : o;
+    game.play(state, player.search(state, 20000, random));
+  }
+  REQUIRE(state.winner == 0);
+}
+
+TEST_CASE("MCTS tree is flat and reused") {
+  Game game;
+  Random random{ 5 };
+  MCTS<Game> mcts{ game };
+  mcts.search(game.initial, 1000, random);
+
+  // The children of a node are contiguous, and every playout goes through one.
+  const auto& nodes = mcts.nodes;
+  REQUIRE(nodes[0].N == 1000);
+  REQUIRE(nodes[0].child_count == 9);
+  float visits = 0;
+  for (uint32_t child = nodes[0].first_child; child < nodes[0].first_child + 9; child++) {
+    REQUIRE(nodes[child].parent == 0);
+    REQUIRE(nodes[child].player == 1);
+    visits += nodes[child].N;
+  }
+  REQUIRE(visits == 1000);  // The first playout expands the root.
+
+  size_t capacity = mcts.nodes.capacity();
+  const auto* data = mcts.nodes.data();
+  mcts.search(game.initial, 1000, random);
+  REQUIRE(mcts.nodes.capacity() == capacity);
+  REQUIRE(mcts.nodes.data() == data);
+}
+
+TEST_CASE("UCB of a tree node uses floating-point averages") {
+  auto parent = std::make_shared<MCT_Node<int, int>>(0, nullptr, 0, 10);
+  MCT_Node<int, int> node{ 0, parent, 1, 2 };
+  REQUIRE(ucb(node) == Approx(0.5 + 1.4 * std::sqrt(std::log(10) / 2)));
+  REQUIRE(ucb(MCT_Node<int, int>{ 0, parent }) == INFINITY);
+  REQUIRE(ucb(0.0f, 0.0f, 1.0f) == INFINITY);
+  REQUIRE(ucb(1.0f, 2.0f, std::log(10.0f)) == Approx(0.5 + 1.4 * std::sqrt(std::log(10) / 2)));
+}
+
+TEST_CASE("Tree-parallel MCTS") {
+  Game game;
+  ThreadPool pool{ 4 };
+  ParallelMCTS<Game> mcts{ game, pool };
+
+  SECTION("finds the winning and blocking moves") {
+    REQUIRE(mcts.search(game.position(1, {{0, 0}, {2, 2}}, {{0, 1}, {2, 1}}), 4000, INFINITY, 1) == 4);
+    REQUIRE(mcts.search(game.position(1, {{0, 0}}, {{0, 1}, {2, 1}}), 8000, INFINITY, 2) == 4);
+  }
+
+  SECTION("backs every playout up, and takes back the virtual losses") {
+    mcts.search(game.initial, 5000, INFINITY, 3);
+    REQUIRE(mcts.playouts() == 5000);
+    uint32_t visits = 0;
+    for (uint32_t child = mcts[0].first_child; child < mcts[0].first_child + mcts[0].child_count; child++) {
+      REQUIRE(mcts[child].parent == 0);
+      visits += mcts[child].N;
+    }
+    REQUIRE(mcts[0].child_count == 9);
+    // Playouts that found the root being expanded by another thread stop there.
+    REQUIRE(visits <= 5000);
+    REQUIRE(visits >= 5000 - pool.size());
+  }
+
+  SECTION("stops at the time budget") {
+    mcts.search(game.initial, std::numeric_limits<size_t>::max(), 0.05, 4);
+    REQUIRE(mcts.playouts() > 0);
+  }
+
+  SECTION("never expands past the arena") {
+    ParallelMCTS<Game> small{ game, pool, 100 };
+    small.search(game.initial, 2000, INFINITY, 5);
+    REQUIRE(small.playouts() == 2000);
+    REQUIRE(small.size() <= 100);
+    small.search(game.initial, 2000, INFINITY, 6);
+    REQUIRE(small.playouts() == 2000);
+    REQUIRE(small.size() <= 100);
+  }
+}
+
+TEST_CASE("Root-parallel MCTS") {
+  Game game;
+  ThreadPool pool{ 4 };
+  REQUIRE(root_parallel_mcts(game, game.position(1, {{0, 0}, {2, 2}}, {{0, 1}, {2, 1}}), 1000, pool, 1) == 4);
+  REQUIRE(root_parallel_mcts(game, game.position(1, {{0, 0}}, {{0, 1}, {2, 1}}), 2000, pool, 2) == 4);
+}
@@ -0,0 +1,273 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <vector>
+
+#include "mcts.cpp"
+#include "../concurrency.cpp"
+#include "../random.cpp"
+
+// ---------------------------------------------------------------------------------
+// Search algorithms: parallel Monte Carlo tree search
+
+/*
+ * Node of a tree shared by several threads. Statistics are atomic counters:
+ * rewards are counted in half points (a win is 2, a draw 1), so they stay
+ * integers. The children fields are written once, by the thread that expands the
+ * node, before it publishes them by setting expansion to expanded.
+ */
+template <typename A>
+struct SharedMCTSNode {
+  enum : uint8_t { unexpanded, expanding, expanded, leaf };  // leaf: not expanded, the arena was full.
+
+  std::atomic<uint32_t> N{ 0 };  // Visits, including virtual losses in flight.
+  std::atomic<uint32_t> W{ 0 };  // Reward of player, in half points.
+  std::atomic<uint8_t> expansion{ unexpanded };
+  uint32_t parent = 0;
+  uint32_t first_child = 0;
+  uint16_t child_count = 0;
+  int8_t player = -1;
+  A action{};
+};
+
+/*
+ * Tree-parallel MCTS: the threads of a pool run playouts on one shared tree.
+ *
+ * A thread descending through a node adds virtual_loss visits without reward to
+ * it, which lowers its UCB for the other threads until the playout is backed
+ * up, so concurrent playouts spread over different branches. A leaf is expanded
+ * by the one thread whose compare-and-swap claims it, into a block of the arena
+ * reserved with an atomic bump of the node count; others meanwhile simulate
+ * from the leaf itself. No locks are taken.
+ *
+ * The arena holds max_nodes nodes; once full, leaves are no longer expanded: a
+ * leaf whose children do not fit is marked as a permanent leaf and simulated from.
+ */
+template <typename G>
+struct ParallelMCTS {
+  using S = typename G::state_type;
+  using A = typename G::action_type;
+  using Node = SharedMCTSNode<A>;
+
+  ParallelMCTS(const G& game, ThreadPool& pool, size_t max_nodes = size_t(1) << 20, float C = 1.4f, uint32_t virtual_loss = 1)
+  : game{ game }, pool{ pool }, C{ C }, virtual_loss{ virtual_loss }, capacity{ max_nodes },
+    nodes{ new Node[max_nodes] } {}
+
+  /*
+   * The most visited action of root after playouts playouts, or after seconds,
+   * whichever comes first. Thread k of the pool draws from the k-th stream split
+   * from Random(seed).
+   */
+  A search(const S& root, size_t playouts, double seconds = std::numeric_limits<double>::infinity(), uint64_t seed = 0) {
+    for (size_t i = 0, end = std::min<size_t>(used.load(), capacity); i < end; i++) {
+      Node& node = nodes[i];
+      node.N = 0;
+      node.W = 0;
+      node.expansion = Node::unexpanded;
+      node.child_count = 0;
+    }
+    used = 1;
+    started = 0;
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+      std::chrono::duration<double>(std::min(seconds, 1e9)));
+    Random streams{ seed };
+    std::vector<Random> random;
+    for (size_t k = 0; k < pool.size(); k++) {
+      random.push_back(streams.split());
+    }
+
+    pool.parallel_for(0, pool.size(), [&](size_t k) {
+      Worker worker{ random[k], {}, {} };
+      while (started.fetch_add(1, std::memory_order_relaxed) < playouts) {
+        if (seconds != std::numeric_limits<double>::infinity() && std::chrono::steady_clock::now() >= deadline) {
+          break;
+        }
+        playout(root, worker);
+      }
+    });
+
+    const Node& top = nodes[0];
+    uint32_t best = top.first_child;
+    for (uint32_t child = top.first_child; child < top.first_child + top.child_count; child++) {
+      if (nodes[child].N.load() > nodes[best].N.load()) {
+        best = child;
+      }
+    }
+    return nodes[best].action;
+  }
+
+  /*
+   * Playouts backed up to the root by the last search.
+   */
+  size_t playouts() const {
+    return nodes[0].N.load();
+  }
+
+  size_t size() const {
+    return used.load();
+  }
+
+  const Node& operator[](uint32_t index) const {
+    return nodes[index];
+  }
+
+private:
+  struct Worker {
+    Random& random;
+    std::vector<uint32_t> path;
+    std::array<A, G::max_actions> buffer;
+  };
+
+  void playout(const S& root, Worker& worker) {
+    S state = root;
+    uint32_t current = 0;
+    worker.path.clear();
+    visit(current, worker);
+
+    // Selection, through expanded nodes only.
+    while (nodes[current].expansion.load(std::memory_order_acquire) == Node::expanded && nodes[current].child_count > 0) {
+      const Node& node = nodes[current];
+      float log_parent = std::log(float(node.N.load(std::memory_order_relaxed)));
+      uint32_t best = node.first_child;
+      float best_score = -std::numeric_limits<float>::infinity();
+      for (uint32_t child = node.first_child; child < node.first_child + node.child_count; child++) {
+        float score = ucb(nodes[child].W.load(std::memory_order_relaxed) / 2.0f, float(nodes[child].N.load(std::memory_order_relaxed)), log_parent, C);
+        if (score > best_score) {
+          best = child;
+          best_score = score;
+        }
+      }
+      current = best;
+      game.play(state, nodes[current].action);
+      visit(current, worker);
+    }
+
+    // Expansion, by the thread that claims the leaf.
+    uint8_t expected = Node::unexpanded;
+    if (nodes[current].expansion.load(std::memory_order_relaxed) == Node::unexpanded &&
+        nodes[current].expansion.compare_exchange_strong(expected, Node::expanding, std::memory_order_acq_rel)) {
+      size_t count = game.actions(state, worker.buffer.data());
+      uint32_t first;
+      if (!reserve(count, first)) {
+        nodes[current].expansion.store(Node::leaf, std::memory_order_release);
+      } else {
+        int8_t player = static_cast<int8_t>(game.to_move(state));
+        for (size_t k = 0; k < count; k++) {
+          Node& child = nodes[first + k];
+          child.parent = current;
+          child.player = player;
+          child.action = worker.buffer[k];
+        }
+        nodes[current].first_child = first;
+        nodes[current].child_count = static_cast<uint16_t>(count);
+        nodes[current].expansion.store(Node::expanded, std::memory_order_release);
+        if (count > 0) {
+          current = first + worker.random.below(count);
+          game.play(state, nodes[current].action);
+          visit(current, worker);
+        }
+      }
+    }
+
+    // Simulation.
+    for (size_t count; (count = game.actions(state, worker.buffer.data())) > 0;) {
+      game.play(state, worker.buffer[worker.random.below(count)]);
+    }
+
+    // Backpropagation, taking back the virtual losses.
+    for (uint32_t index : worker.path) {
+      Node& node = nodes[index];
+      if (node.player >= 0) {
+        node.W.fetch_add(static_cast<uint32_t>(game.utility(state, node.player) + 1), std::memory_order_relaxed);
+      }
+      node.N.fetch_sub(virtual_loss, std::memory_order_relaxed);
+    }
+  }
+
+  /*
+   * Reserves count consecutive nodes of the arena, starting at first. Fails,
+   * leaving the node count unchanged, if they do not fit.
+   */
+  bool reserve(size_t count, uint32_t& first) {
+    first = used.load(std::memory_order_relaxed);
+    do {
+      if (first + count > capacity) {
+        return false;
+      }
+    } while (!used.compare_exchange_weak(first, static_cast<uint32_t>(first + count), std::memory_order_relaxed));
+    return true;
+  }
+
+  /*
+   * Counts the visit of a node on the way down, with its virtual loss.
+   */
+  void visit(uint32_t index, Worker& worker) {
+    nodes[index].N.fetch_add(1 + virtual_loss, std::memory_order_relaxed);
+    worker.path.push_back(index);
+  }
+
+  const G& game;
+  ThreadPool& pool;
+  float C;
+  uint32_t virtual_loss;
+  size_t capacity;
+  std::unique_ptr<Node[]> nodes;
+  std::atomic<uint32_t> used{ 1 };
+  std::atomic<size_t> started{ 0 };
+};
+
+/*
+ * Root-parallel MCTS: every thread of the pool searches its own tree from state
+ * with playouts playouts, and the visits of the root actions are summed over the
+ * trees. Returns the most visited action. Needs no shared memory, at the price
+ * of trees that repeat each other's work.
+ */
+template <typename G>
+typename G::action_type root_parallel_mcts(
+  const G& game,
+  const typename G::state_type& state,
+  size_t playouts,
+  ThreadPool& pool,
+  uint64_t seed = 0
+) {
+  using A = typename G::action_type;
+
+  Random streams{ seed };
+  std::vector<Random> random;
+  for (size_t k = 0; k < pool.size(); k++) {
+    random.push_back(streams.split());
+  }
+
+  std::vector<std::vector<std::pair<A, float>>> visits(pool.size());
+  pool.parallel_for(0, pool.size(), [&](size_t k) {
+    MCTS<G> mcts{ game };
+    mcts.search(state, playouts, random[k]);
+    const auto& root = mcts.nodes[0];
+    for (uint32_t child = root.first_child; child < root.first_child + root.child_count; child++) {
+      visits[k].emplace_back(mcts.nodes[child].action, mcts.nodes[child].N);
+    }
+  });
+
+  // Every tree lists the root actions in the same order.
+  std::vector<std::pair<A, float>> merged = visits[0];
+  for (size_t k = 1; k < visits.size(); k++) {
+    for (size_t i = 0; i < merged.size(); i++) {
+      merged[i].second += visits[k][i].second;
+    }
+  }
+  size_t best = 0;
+  for (size_t i = 1; i < merged.size(); i++) {
+    if (merged[i].second > merged[best].second) {
+      best = i;
+    }
+  }
+  return merged.empty() ? A{} : merged[best].first;
+}
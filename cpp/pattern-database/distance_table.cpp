@@ -0,0 +1,457 @@
+#pragma once
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// ---------------------------------------------------------------------------------
+// Complete distance tables for small sliding-tile puzzles
+
+/*
+ * The exact distance to the goal of every solvable board of a width x height
+ * sliding-tile puzzle, computed once by a breadth-first search from the goal.
+ * Meant for the 8-puzzle (181,440 solvable boards); boards of up to 12 cells
+ * are accepted, but the 3 x 4 table already takes 239 MB.
+ *
+ * Boards are flat, in row-major order, as in PatternDatabase. Only half of the
+ * boards are solvable: for a given blank cell, swapping two tiles flips
+ * solvability. So a board is indexed by its blank cell and by the rank of its
+ * first cells - 3 tiles (in reading order, the blank skipped), which decide the
+ * order of the last two: a perfect hash of the solvable boards, and the table has
+ * no hole. It stores one byte per board, as the distances of the 8-puzzle reach
+ * 31 and do not fit in 4 bits.
+ *
+ * Every move changes the distance by exactly one, so an optimal solution is
+ * found by greedy descent: move to a neighbour one step closer, depth times.
+ *
+ * Tables can be saved, then loaded into memory or mapped read-only from the file,
+ * in which case processes mapping the same file share its pages.
+ */
+struct DistanceTable {
+  DistanceTable(int width, int height, std::vector<int> goal)
+  : width{ width }, height{ height }, goal{ goal } {
+    if (!valid_goal()) {
+      throw std::invalid_argument{ "Goal must hold every tile of a board of 4 to 12 cells exactly once" };
+    }
+    index_goal();
+    build();
+  }
+
+  /*
+   * True if board can reach the goal: the parity of the permutation from board
+   * to goal has to be the parity of the blank's distance to its goal cell.
+   * Throws invalid_argument if board does not hold every tile exactly once.
+   */
+  template <typename Board>
+  bool solvable(const Board& board) const {
+    int cells = width * height;
+    uint32_t seen = 0;
+    for (int cell = 0; cell < cells; cell++) {
+      int tile = int(board[cell]);
+      if (tile < 0 || tile >= cells || (seen & (uint32_t{ 1 } << tile))) {
+        throw std::invalid_argument{ "Board must hold every tile exactly once" };
+      }
+      seen |= uint32_t{ 1 } << tile;
+    }
+
+    bool visited[16] = {};
+    int transpositions = 0;
+    int blank = 0;
+    for (int cell = 0; cell < cells; cell++) {
+      for (int length = 0, next = cell; !visited[next]; length++) {
+        visited[next] = true;
+        next = goal_cell[int(board[next])];
+        transpositions += length > 0;
+      }
+      if (board[cell] == 0) {
+        blank = cell;
+      }
+    }
+    int blank_goal = goal_cell[0];
+    int blank_distance = std::abs(blank / width - blank_goal / width) + std::abs(blank % width - blank_goal % width);
+    return transpositions % 2 == blank_distance % 2;
+  }
+
+  /*
+   * Fewest moves from board to the goal. board has to be solvable.
+   */
+  template <typename Board>
+  int distance(const Board& board) const {
+    return data()[rank(board)];
+  }
+
+  /*
+   * Exact distance, as a heuristic.
+   */
+  template <typename Board>
+  int h(const Board& board) const {
+    return distance(board);
+  }
+
+  /*
+   * An optimal solution of board: the cells the blank moves to, one per move.
+   * Throws invalid_argument if board does not hold every tile exactly once, or
+   * cannot reach the goal.
+   */
+  template <typename Board>
+  std::vector<int> solve(const Board& board) const {
+    int cells = width * height;
+    if (!solvable(board)) {
+      throw std::invalid_argument{ "Board cannot reach the goal" };
+    }
+    int tiles[16];
+    int blank = 0;
+    for (int cell = 0; cell < cells; cell++) {
+      tiles[cell] = board[cell];
+      if (tiles[cell] == 0) {
+        blank = cell;
+      }
+    }
+
+    const uint8_t* distances = data();
+    int remaining = distances[rank(tiles)];
+    std::vector<int> moves;
+    moves.reserve(remaining);
+    while (remaining > 0) {
+      int closer = -1;
+      for (int cell : neighbours(blank)) {
+        if (cell < 0) {
+          continue;
+        }
+        std::swap(tiles[blank], tiles[cell]);
+        bool found = distances[rank(tiles)] == remaining - 1;
+        std::swap(tiles[blank], tiles[cell]);
+        if (found) {
+          closer = cell;
+          break;
+        }
+      }
+      if (closer < 0) {
+        throw std::runtime_error{ "Corrupted distance table: no neighbour is closer to the goal" };
+      }
+      std::swap(tiles[blank], tiles[closer]);
+      moves.push_back(closer);
+      blank = closer;
+      remaining--;
+    }
+    return moves;
+  }
+
+  /*
+   * Largest distance in the table.
+   */
+  int max_distance() const {
+    const uint8_t* distances = data();
+    return *std::max_element(distances, distances + size_bytes());
+  }
+
+  /*
+   * Memory used by the table: one byte per solvable board.
+   */
+  size_t size_bytes() const {
+    return boards(width * height);
+  }
+
+  /*
+   * True if the table is mapped from a file rather than held in memory.
+   */
+  bool mapped() const {
+    return bool(mapping);
+  }
+
+  /*
+   * Writes the table to path, so it can be loaded or mapped instead of rebuilt.
+   */
+  void save(const std::string& path) const {
+    std::ofstream out{ path, std::ios::binary };
+    write(out, magic);
+    write(out, width);
+    write(out, height);
+    for (int tile : goal) {
+      write(out, tile);
+    }
+    out.write(reinterpret_cast<const char*>(data()), size_bytes());
+    if (!out) {
+      throw std::runtime_error{ "Could not write distance table to " + path };
+    }
+  }
+
+  /*
+   * Reads a table written by save into memory.
+   */
+  static DistanceTable load(const std::string& path) {
+    std::ifstream in{ path, std::ios::binary };
+    if (read<uint32_t>(in) != magic) {
+      throw std::runtime_error{ "Not a distance table: " + path };
+    }
+    DistanceTable table;
+    table.width = std::clamp(read<int>(in), 0, 12);
+    table.height = std::clamp(read<int>(in), 0, 12);
+    table.read_goal(in, path);
+    table.table.resize(table.size_bytes());
+    in.read(reinterpret_cast<char*>(table.table.data()), table.table.size());
+    if (!in) {
+      throw std::runtime_error{ "Corrupted distance table: " + path };
+    }
+    return table;
+  }
+
+  /*
+   * Maps a table written by save, read-only. The file stays mapped until the
+   * last copy of the table is destroyed.
+   */
+  static DistanceTable map(const std::string& path) {
+    int file = ::open(path.c_str(), O_RDONLY);
+    if (file < 0) {
+      throw std::runtime_error{ "Could not open distance table " + path };
+    }
+    struct stat status;
+    size_t length = ::fstat(file, &status) == 0 ? size_t(status.st_size) : 0;
+    void* base = length > 0 ? ::mmap(nullptr, length, PROT_READ, MAP_SHARED, file, 0) : MAP_FAILED;
+    ::close(file);
+    if (base == MAP_FAILED) {
+      throw std::runtime_error{ "Could not map distance table " + path };
+    }
+    std::shared_ptr<const uint8_t> region{ static_cast<const uint8_t*>(base), [length](const uint8_t* start) {
+      ::munmap(const_cast<uint8_t*>(start), length);
+    } };
+
+    const uint8_t* bytes = region.get();
+    auto field = [&](size_t index) {
+      int value;
+      std::memcpy(&value, bytes + sizeof(uint32_t) + index * sizeof(int), sizeof value);
+      return value;
+    };
+    uint32_t header = 0;
+    if (length >= sizeof(uint32_t) + 2 * sizeof(int)) {
+      std::memcpy(&header, bytes, sizeof header);
+    }
+    if (header != magic) {
+      throw std::runtime_error{ "Not a distance table: " + path };
+    }
+
+    DistanceTable table;
+    table.width = std::clamp(field(0), 0, 12);
+    table.height = std::clamp(field(1), 0, 12);
+    int cells = table.width * table.height;
+    size_t offset = sizeof(uint32_t) + (2 + cells) * sizeof(int);
+    if (table.width < 2 || table.height < 2 || cells > 12 || length != offset + table.size_bytes()) {
+      throw std::runtime_error{ "Corrupted distance table: " + path };
+    }
+    for (int cell = 0; cell < cells; cell++) {
+      table.goal.push_back(field(2 + cell));
+    }
+    if (!table.valid_goal()) {
+      throw std::runtime_error{ "Corrupted distance table: " + path };
+    }
+    table.index_goal();
+    table.mapping = std::shared_ptr<const uint8_t>{ region, bytes + offset };
+    return table;
+  }
+
+  int width;
+  int height;
+  std::vector<int> goal;
+
+private:
+  static constexpr uint32_t magic = 0x31425444;  // "DTB1"
+  static constexpr uint8_t unreached = 0xFF;
+
+  DistanceTable() = default;
+
+  const uint8_t* data() const {
+    return mapping ? mapping.get() : table.data();
+  }
+
+  /*
+   * cells! / 2: the number of solvable boards of cells cells, or of placements
+   * of cells tiles decided by the first cells - 2.
+   */
+  static size_t boards(int cells) {
+    size_t n = 1;
+    for (int i = 3; i <= cells; i++) {
+      n *= i;
+    }
+    return n;
+  }
+
+  /*
+   * True if the board is 2 x 2 to 12 cells, and goal holds each of its tiles once.
+   */
+  bool valid_goal() const {
+    int cells = width * height;
+    if (width < 2 || height < 2 || cells > 12 || int(goal.size()) != cells) {
+      return false;
+    }
+    std::vector<bool> seen(cells, false);
+    for (int tile : goal) {
+      if (tile < 0 || tile >= cells || seen[tile]) {
+        return false;
+      }
+      seen[tile] = true;
+    }
+    return true;
+  }
+
+  void index_goal() {
+    for (int cell = 0; cell < width * height; cell++) {
+      goal_cell[goal[cell]] = cell;
+    }
+  }
+
+  /*
+   * Cells next to cell (up, down, left, right), or -1 off the board.
+   */
+  std::array<int, 4> neighbours(int cell) const {
+    int row = cell / width, col = cell % width;
+    return {
+      row > 0 ? cell - width : -1,
+      row < height - 1 ? cell + width : -1,
+      col > 0 ? cell - 1 : -1,
+      col < width - 1 ? cell + 1 : -1,
+    };
+  }
+
+  /*
+   * Index of a solvable board: its blank cell, then the rank of its first
+   * cells - 3 tiles (the blank skipped) among the (cells - 3)-permutations of
+   * the tiles, in lexicographic order.
+   */
+  template <typename Board>
+  size_t rank(const Board& board) const {
+    int cells = width * height;
+    uint32_t used = 0;
+    size_t r = 0;
+    int blank = 0;
+    for (int cell = 0, i = 0; cell < cells; cell++) {
+      int tile = board[cell];
+      if (tile == 0) {
+        blank = cell;
+      } else if (i < cells - 3) {
+        uint32_t below = (uint32_t{ 1 } << tile) - 1;
+        r = r * (cells - 1 - i) + (tile - 1 - __builtin_popcount(used & below));
+        used |= uint32_t{ 1 } << tile;
+        i++;
+      }
+    }
+    return blank * boards(cells - 1) + r;
+  }
+
+  /*
+   * Inverse of rank: the solvable board of index r.
+   */
+  void unrank(size_t r, int* board) const {
+    int cells = width * height;
+    int blank = r / boards(cells - 1);
+    r %= boards(cells - 1);
+
+    int tiles[16];
+    for (int i = cells - 3; i-- > 0;) {
+      tiles[i] = r % (cells - 1 - i);
+      r /= cells - 1 - i;
+    }
+    uint32_t used = 0;
+    for (int i = 0; i < cells - 3; i++) {
+      int skip = tiles[i];
+      int tile = 1;
+      while ((used & (uint32_t{ 1 } << tile)) || skip-- > 0) {
+        tile++;
+      }
+      tiles[i] = tile;
+      used |= uint32_t{ 1 } << tile;
+    }
+    for (int tile = 1, last = cells - 3; tile < cells; tile++) {
+      if (!(used & (uint32_t{ 1 } << tile))) {
+        tiles[last++] = tile;
+      }
+    }
+
+    int first_of_last_two = 0;
+    for (int cell = 0, i = 0; cell < cells; cell++) {
+      if (cell == blank) {
+        board[cell] = 0;
+      } else {
+        if (i == cells - 3) {
+          first_of_last_two = cell;
+        }
+        board[cell] = tiles[i++];
+      }
+    }
+    if (!solvable(board)) {
+      int second = first_of_last_two + 1 == blank ? blank + 1 : first_of_last_two + 1;
+      std::swap(board[first_of_last_two], board[second]);
+    }
+  }
+
+  /*
+   * Breadth-first search from the goal, one layer after another.
+   */
+  void build() {
+    int cells = width * height;
+    table.assign(boards(cells), unreached);
+    std::vector<uint32_t> layer{ uint32_t(rank(goal)) };
+    std::vector<uint32_t> next_layer;
+    table[layer[0]] = 0;
+
+    int board[16];
+    for (int depth = 1; !layer.empty(); depth++) {
+      next_layer.clear();
+      for (uint32_t current : layer) {
+        unrank(current, board);
+        int blank = std::find(board, board + cells, 0) - board;
+        for (int cell : neighbours(blank)) {
+          if (cell < 0) {
+            continue;
+          }
+          std::swap(board[blank], board[cell]);
+          size_t next = rank(board);
+          if (table[next] == unreached) {
+            table[next] = depth;
+            next_layer.push_back(next);
+          }
+          std::swap(board[blank], board[cell]);
+        }
+      }
+      layer.swap(next_layer);
+    }
+  }
+
+  void read_goal(std::ifstream& in, const std::string& path) {
+    int cells = width * height;
+    for (int cell = 0; in && cell < std::min(cells, 12); cell++) {
+      goal.push_back(read<int>(in));
+    }
+    if (!in || !valid_goal()) {
+      throw std::runtime_error{ "Corrupted distance table: " + path };
+    }
+    index_goal();
+  }
+
+  template <typename T>
+  static void write(std::ofstream& out, T value) {
+    out.write(reinterpret_cast<const char*>(&value), sizeof value);
+  }
+
+  template <typename T>
+  static T read(std::ifstream& in) {
+    T value{};
+    in.read(reinterpret_cast<char*>(&value), sizeof value);
+    return value;
+  }
+
+  int goal_cell[16];
+  std::vector<uint8_t> table;              // Built or loaded.
+  std::shared_ptr<const uint8_t> mapping;  // Or mapped.
+};
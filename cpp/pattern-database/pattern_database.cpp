@@ -0,0 +1,422 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// ---------------------------------------------------------------------------------
+// Pattern databases for sliding-tile puzzles
+
+/*
+ * Additive, disjoint pattern databases for a width x height sliding-tile puzzle.
+ *
+ * The tiles are split in disjoint patterns. For each pattern, a backward
+ * breadth-first search from the goal computes, for every placement of the
+ * pattern's tiles, the fewest moves *of those tiles* needed to put them in their
+ * goal cells; moves of the other tiles are free. As no move is counted by two
+ * patterns, the sum over patterns is an admissible heuristic, and it dominates
+ * the Manhattan distance.
+ *
+ * Boards are flat, in row-major order: board[cell] is the tile at cell, 0 being
+ * the blank. Each table holds one byte per placement, indexed by the rank of the
+ * placement among the k-permutations of the cells, so h costs one lookup per
+ * pattern.
+ */
+struct PatternDatabase {
+  PatternDatabase(int width, int height, std::vector<int> goal, std::vector<std::vector<int>> patterns)
+  : width{ width }, height{ height }, goal{ goal } {
+    if (!valid_goal()) {
+      throw std::invalid_argument{ "Goal must hold every tile of a board of at most 64 cells exactly once" };
+    }
+    if (!disjoint(patterns)) {
+      throw std::invalid_argument{ "Patterns must be disjoint sets of tiles" };
+    }
+    for (const std::vector<int>& tiles : patterns) {
+      this->patterns.push_back(Pattern{ tiles, {} });
+    }
+
+    for (Pattern& pattern : this->patterns) {
+      build(pattern);
+    }
+  }
+
+  /*
+   * Sum of the pattern distances of board. Throws invalid_argument if board does
+   * not hold every tile exactly once.
+   */
+  template <typename Board>
+  int h(const Board& board) const {
+    int cells = width * height;
+    int position_of[64];
+    uint64_t seen = 0;
+    for (int cell = 0; cell < cells; cell++) {
+      int tile = int(board[cell]);
+      if (tile < 0 || tile >= cells || (seen & (uint64_t{ 1 } << tile))) {
+        throw std::invalid_argument{ "Board must hold every tile exactly once" };
+      }
+      seen |= uint64_t{ 1 } << tile;
+      position_of[tile] = cell;
+    }
+
+    int total = 0;
+    int positions[64];
+    for (const Pattern& pattern : patterns) {
+      for (size_t i = 0; i < pattern.tiles.size(); i++) {
+        positions[i] = position_of[pattern.tiles[i]];
+      }
+      uint8_t distance = pattern.distances[rank(positions, pattern.tiles.size())];
+      total += distance == unreachable ? 0 : distance;
+    }
+    return total;
+  }
+
+  /*
+   * Memory used by the tables.
+   */
+  size_t size_bytes() const {
+    size_t total = 0;
+    for (const Pattern& pattern : patterns) {
+      total += pattern.distances.size();
+    }
+    return total;
+  }
+
+  /*
+   * Writes the tables to path, so they can be loaded instead of rebuilt.
+   */
+  void save(const std::string& path) const {
+    std::ofstream out{ path, std::ios::binary };
+    write(out, magic);
+    write(out, width);
+    write(out, height);
+    for (int tile : goal) {
+      write(out, tile);
+    }
+    write(out, int(patterns.size()));
+    for (const Pattern& pattern : patterns) {
+      write(out, int(pattern.tiles.size()));
+      for (int tile : pattern.tiles) {
+        write(out, tile);
+      }
+      out.write(reinterpret_cast<const char*>(pattern.distances.data()), pattern.distances.size());
+    }
+    if (!out) {
+      throw std::runtime_error{ "Could not write pattern database to " + path };
+    }
+  }
+
+  /*
+   * Reads tables written by save.
+   */
+  static PatternDatabase load(const std::string& path) {
+    std::ifstream in{ path, std::ios::binary };
+    if (read<uint32_t>(in) != magic) {
+      throw std::runtime_error{ "Not a pattern database: " + path };
+    }
+
+    PatternDatabase database;
+    database.width = read<int>(in);
+    database.height = read<int>(in);
+    int cells = database.width * database.height;
+    if (!in || database.width <= 0 || database.height <= 0 || cells > 64) {
+      throw std::runtime_error{ "Corrupted pattern database: " + path };
+    }
+    for (int cell = 0; cell < cells; cell++) {
+      database.goal.push_back(read<int>(in));
+    }
+
+    int count = std::clamp(read<int>(in), 0, cells);
+    std::vector<std::vector<int>> patterns;
+    for (int p = 0; p < count && in; p++) {
+      Pattern pattern;
+      pattern.tiles.resize(std::clamp(read<int>(in), 0, cells));
+      for (int& tile : pattern.tiles) {
+        tile = read<int>(in);
+      }
+      patterns.push_back(pattern.tiles);
+      if (!in || !database.disjoint(patterns)) {
+        throw std::runtime_error{ "Corrupted pattern database: " + path };
+      }
+      pattern.distances.resize(database.placements(pattern.tiles.size()));
+      in.read(reinterpret_cast<char*>(pattern.distances.data()), pattern.distances.size());
+      database.patterns.push_back(std::move(pattern));
+    }
+    if (!in || !database.valid_goal()) {
+      throw std::runtime_error{ "Corrupted pattern database: " + path };
+    }
+    return database;
+  }
+
+  int width;
+  int height;
+  std::vector<int> goal;
+
+private:
+  static constexpr uint32_t magic = 0x31424450;  // "PDB1"
+  static constexpr uint8_t unreachable = 0xFF;
+
+  struct Pattern {
+    std::vector<int> tiles;
+    std::vector<uint8_t> distances;
+  };
+
+  PatternDatabase() = default;
+
+  bool valid_goal() const {
+    int cells = width * height;
+    if (width <= 0 || height <= 0 || cells > 64 || int(goal.size()) != cells) {
+      return false;
+    }
+    uint64_t seen = 0;
+    for (int tile : goal) {
+      if (tile < 0 || tile >= cells || (seen & (uint64_t{ 1 } << tile))) {
+        return false;
+      }
+      seen |= uint64_t{ 1 } << tile;
+    }
+    return true;
+  }
+
+  /*
+   * True if patterns are disjoint sets of tiles, the blank excluded.
+   */
+  bool disjoint(const std::vector<std::vector<int>>& patterns) const {
+    int cells = width * height;
+    uint64_t used = 0;
+    for (const std::vector<int>& tiles : patterns) {
+      for (int tile : tiles) {
+        if (tile <= 0 || tile >= cells || (used & (uint64_t{ 1 } << tile))) {
+          return false;
+        }
+        used |= uint64_t{ 1 } << tile;
+      }
+    }
+    return true;
+  }
+
+  /*
+   * Number of placements of k distinct tiles on the board.
+   */
+  size_t placements(size_t k) const {
+    size_t cells = width * height;
+    size_t n = 1;
+    for (size_t i = 0; i < k; i++) {
+      n *= cells - i;
+    }
+    return n;
+  }
+
+  /*
+   * Rank of a placement (positions[i] is the cell of the i-th tile) among the
+   * k-permutations of the cells, in lexicographic order.
+   */
+  size_t rank(const int* positions, size_t k) const {
+    size_t cells = width * height;
+    uint64_t used = 0;
+    size_t r = 0;
+    for (size_t i = 0; i < k; i++) {
+      uint64_t below = (uint64_t{ 1 } << positions[i]) - 1;
+      size_t digit = positions[i] - __builtin_popcountll(used & below);
+      r = r * (cells - i) + digit;
+      used |= uint64_t{ 1 } << positions[i];
+    }
+    return r;
+  }
+
+  /*
+   * Inverse of rank.
+   */
+  void unrank(size_t r, size_t k, int* positions) const {
+    size_t cells = width * height;
+    for (size_t i = k; i-- > 0;) {
+      positions[i] = r % (cells - i);
+      r /= cells - i;
+    }
+    uint64_t used = 0;
+    for (size_t i = 0; i < k; i++) {
+      int skip = positions[i];
+      int cell = 0;
+      while (true) {
+        if (!(used & (uint64_t{ 1 } << cell)) && skip-- == 0) {
+          break;
+        }
+        cell++;
+      }
+      positions[i] = cell;
+      used |= uint64_t{ 1 } << cell;
+    }
+  }
+
+  /*
+   * States of the search of build, two bits each: unreached, in the level being
+   * expanded, in the next level, or expanded.
+   */
+  struct Levels {
+    enum : uint64_t { unreached, current, next, expanded };
+
+    explicit Levels(size_t states) : bits((2 * states + 63) / 64, 0) {}
+
+    uint64_t get(size_t state) const {
+      return (bits[state / 32] >> (2 * (state % 32))) & 3;
+    }
+
+    void set(size_t state, uint64_t value) {
+      uint64_t& word = bits[state / 32];
+      int shift = 2 * (state % 32);
+      word = (word & ~(uint64_t{ 3 } << shift)) | (value << shift);
+    }
+
+    /*
+     * Calls expand(state) for every state of the current level. Calls may change
+     * other states, so expand checks that its state is still current.
+     */
+    template <typename Expand>
+    void each_current(Expand expand) {
+      for (size_t w = 0; w < bits.size(); w++) {
+        uint64_t current_pairs = bits[w] & ~(bits[w] >> 1) & low_bits;
+        while (current_pairs) {
+          expand(w * 32 + __builtin_ctzll(current_pairs) / 2);
+          current_pairs &= current_pairs - 1;
+        }
+      }
+    }
+
+    /*
+     * Makes the next level current.
+     */
+    void advance() {
+      for (uint64_t& word : bits) {
+        uint64_t next_pairs = (word >> 1) & ~word & low_bits;
+        word ^= next_pairs | (next_pairs << 1);
+      }
+    }
+
+    static constexpr uint64_t low_bits = 0x5555555555555555;
+    std::vector<uint64_t> bits;
+  };
+
+  /*
+   * Index of cell among the cells not in occupied, and its inverse.
+   */
+  static size_t free_index(uint64_t occupied, int cell) {
+    return cell - __builtin_popcountll(occupied & ((uint64_t{ 1 } << cell) - 1));
+  }
+
+  static int free_cell(uint64_t occupied, size_t index) {
+    uint64_t free = ~occupied;
+    for (size_t i = 0; i < index; i++) {
+      free &= free - 1;
+    }
+    return __builtin_ctzll(free);
+  }
+
+  /*
+   * Breadth-first search from the goal. The blank moves for free among the cells
+   * no pattern tile covers, so a state is a placement with the region of free
+   * cells that holds the blank, and moving a pattern tile into the region costs
+   * 1. A state is numbered placement * free cells + the free index of any cell of
+   * its region; the search keeps two bits per such number, a quarter of a byte
+   * per (placement, blank cell), and finds each level by scanning them instead
+   * of queueing states. The table keeps, for each placement, the level it was
+   * first reached at: its minimum over the regions of the blank.
+   */
+  void build(Pattern& pattern) {
+    size_t k = pattern.tiles.size();
+    size_t cells = width * height;
+    size_t free = cells - k;
+    Levels levels{ placements(k) * free };
+    pattern.distances.assign(placements(k), unreachable);
+
+    uint64_t board = cells == 64 ? ~uint64_t{ 0 } : (uint64_t{ 1 } << cells) - 1;
+    uint64_t first_column = 0;
+    for (int row = 0; row < height; row++) {
+      first_column |= uint64_t{ 1 } << (row * width);
+    }
+    uint64_t last_column = first_column << (width - 1);
+    auto grow = [&](uint64_t mask) {  // The cells of mask and their neighbours.
+      return (mask | ((mask << 1) & ~first_column) | ((mask >> 1) & ~last_column) | (mask << width) | (mask >> width)) & board;
+    };
+
+    int positions[64];
+    int blank = 0;
+    uint64_t goal_occupied = 0;
+    for (size_t cell = 0; cell < cells; cell++) {
+      for (size_t i = 0; i < k; i++) {
+        if (goal[cell] == pattern.tiles[i]) {
+          positions[i] = cell;
+          goal_occupied |= uint64_t{ 1 } << cell;
+        }
+      }
+      if (goal[cell] == 0) {
+        blank = cell;
+      }
+    }
+    size_t start = rank(positions, k);
+    levels.set(start * free + free_index(goal_occupied, blank), Levels::current);
+    pattern.distances[start] = 0;
+
+    for (int depth = 0; depth + 1 < unreachable; depth++) {
+      bool next_level = false;
+      levels.each_current([&](size_t state) {
+        if (levels.get(state) != Levels::current) {
+          return;
+        }
+        size_t placement = state / free;
+        unrank(placement, k, positions);
+        uint64_t occupied = 0;
+        for (size_t i = 0; i < k; i++) {
+          occupied |= uint64_t{ 1 } << positions[i];
+        }
+
+        uint64_t region = uint64_t{ 1 } << free_cell(occupied, state % free);
+        for (uint64_t grown; (grown = grow(region) & ~occupied) != region;) {
+          region = grown;
+        }
+        for (uint64_t cells_left = region; cells_left; cells_left &= cells_left - 1) {
+          levels.set(placement * free + free_index(occupied, __builtin_ctzll(cells_left)), Levels::expanded);
+        }
+
+        for (size_t i = 0; i < k; i++) {
+          int from = positions[i];
+          uint64_t targets = grow(uint64_t{ 1 } << from) & region;
+          for (; targets; targets &= targets - 1) {
+            positions[i] = __builtin_ctzll(targets);
+            size_t next = rank(positions, k);
+            uint64_t next_occupied = occupied ^ (uint64_t{ 1 } << from) ^ (uint64_t{ 1 } << positions[i]);
+            size_t next_state = next * free + free_index(next_occupied, from);
+            if (levels.get(next_state) == Levels::unreached) {
+              levels.set(next_state, Levels::next);
+              next_level = true;
+              if (pattern.distances[next] == unreachable) {
+                pattern.distances[next] = depth + 1;
+              }
+            }
+          }
+          positions[i] = from;
+        }
+      });
+      if (!next_level) {
+        break;
+      }
+      levels.advance();
+    }
+  }
+
+  template <typename T>
+  static void write(std::ofstream& out, T value) {
+    out.write(reinterpret_cast<const char*>(&value), sizeof value);
+  }
+
+  template <typename T>
+  static T read(std::ifstream& in) {
+    T value{};
+    in.read(reinterpret_cast<char*>(&value), sizeof value);
+    return value;
+  }
+
+  std::vector<Pattern> patterns;
+};
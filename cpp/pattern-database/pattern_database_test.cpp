@@ -0,0 +1,227 @@
+#define CATCH_CONFIG_MAIN
+#include "../catch.hpp"
+#include "distance_table.cpp"
+#include "pattern_database.cpp"
+
+#include <cstdio>
+
+using Board = std::vector<int>;
+
+/*
+ * Slides the blank at random, steps times.
+ */
+Board random_walk(Board board, int width, int height, int steps) {
+  int blank = std::find(board.begin(), board.end(), 0) - board.begin();
+  for (int step = 0; step < steps; step++) {
+    int row = blank / width, col = blank % width;
+    int next = blank;
+    switch (rand() % 4) {
+      case 0: if (row > 0) next -= width; break;
+      case 1: if (row < height - 1) next += width; break;
+      case 2: if (col > 0) next -= 1; break;
+      case 3: if (col < width - 1) next += 1; break;
+    }
+    std::swap(board[blank], board[next]);
+    blank = next;
+  }
+  return board;
+}
+
+int manhattan(const Board& board, const Board& goal, int width) {
+  int total = 0;
+  for (int cell = 0; cell < int(board.size()); cell++) {
+    if (board[cell] == 0) continue;
+    int target = std::find(goal.begin(), goal.end(), board[cell]) - goal.begin();
+    total += std::abs(cell / width - target / width) + std::abs(cell % width - target % width);
+  }
+  return total;
+}
+
+TEST_CASE("8 Puzzle pattern database") {
+  Board goal = { 0, 1, 2, 3, 4, 5, 6, 7, 8 };
+  PatternDatabase database{ 3, 3, goal, { { 1, 2, 3, 4 }, { 5, 6, 7, 8 } } };
+
+  SECTION("is zero at the goal") {
+    REQUIRE(database.h(goal) == 0);
+  }
+
+  SECTION("counts the moves of pattern tiles") {
+    Board one_move = { 1, 0, 2, 3, 4, 5, 6, 7, 8 };
+    REQUIRE(database.h(one_move) == 1);
+  }
+
+  SECTION("dominates the Manhattan distance") {
+    srand(7);
+    for (int i = 0; i < 200; i++) {
+      Board board = random_walk(goal, 3, 3, 40);
+      REQUIRE(database.h(board) >= manhattan(board, goal, 3));
+    }
+  }
+
+  SECTION("stores one byte per placement") {
+    REQUIRE(database.size_bytes() == 2 * 9 * 8 * 7 * 6);
+  }
+
+  SECTION("survives a save and load round trip") {
+    std::string path = "pattern_database_test.bin";
+    database.save(path);
+    PatternDatabase loaded = PatternDatabase::load(path);
+    std::remove(path.c_str());
+
+    srand(11);
+    for (int i = 0; i < 50; i++) {
+      Board board = random_walk(goal, 3, 3, 30);
+      REQUIRE(loaded.h(board) == database.h(board));
+    }
+  }
+}
+
+TEST_CASE("Pattern databases reject overlapping patterns") {
+  Board goal = { 0, 1, 2, 3, 4, 5, 6, 7, 8 };
+  REQUIRE_THROWS_AS((PatternDatabase{ 3, 3, goal, { { 1, 2 }, { 2, 3 } } }), std::invalid_argument);
+  REQUIRE_THROWS_AS((PatternDatabase{ 3, 3, goal, { { 0, 1 } } }), std::invalid_argument);
+  REQUIRE_THROWS_AS((PatternDatabase{ 3, 3, { 0, 1, 2, 3, 4, 5, 6, 7, 7 }, { { 1, 2 } } }), std::invalid_argument);
+}
+
+TEST_CASE("Pattern databases reject bad tiles") {
+  Board goal = { 0, 1, 2, 3, 4, 5, 6, 7, 8 };
+  PatternDatabase database{ 3, 3, goal, { { 1, 2, 3, 4 }, { 5, 6, 7, 8 } } };
+
+  SECTION("in boards") {
+    REQUIRE_THROWS_AS(database.h(Board{ 0, 1, 2, 3, 4, 5, 6, 7, 64 }), std::invalid_argument);
+    REQUIRE_THROWS_AS(database.h(Board{ 0, 1, 2, 3, 4, 5, 6, 7, -1 }), std::invalid_argument);
+    REQUIRE_THROWS_AS(database.h(Board{ 0, 1, 2, 3, 4, 5, 6, 7, 7 }), std::invalid_argument);
+  }
+
+  SECTION("in saved files") {
+    std::string path = "pattern_database_test.bin";
+    database.save(path);
+    {
+      std::fstream file{ path, std::ios::in | std::ios::out | std::ios::binary };
+      file.seekp(3 * sizeof(int));  // The first tile of the goal.
+      int tile = 100;
+      file.write(reinterpret_cast<const char*>(&tile), sizeof tile);
+    }
+    REQUIRE_THROWS_AS(PatternDatabase::load(path), std::runtime_error);
+    std::remove(path.c_str());
+  }
+}
+
+TEST_CASE("15 Puzzle pattern database") {
+  Board goal = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 0 };
+  PatternDatabase database{ 4, 4, goal, { { 1, 2, 5, 6 }, { 3, 4, 7, 8 }, { 9, 10, 13, 14 }, { 11, 12, 15 } } };
+
+  REQUIRE(database.h(goal) == 0);
+  srand(3);
+  for (int i = 0; i < 100; i++) {
+    Board board = random_walk(goal, 4, 4, 60);
+    REQUIRE(database.h(board) >= manhattan(board, goal, 4));
+  }
+}
+
+/*
+ * Plays the moves of a solution (the cells the blank moves to) on board.
+ */
+Board play(Board board, const std::vector<int>& moves, int width) {
+  int blank = std::find(board.begin(), board.end(), 0) - board.begin();
+  for (int cell : moves) {
+    REQUIRE(std::abs(cell / width - blank / width) + std::abs(cell % width - blank % width) == 1);
+    std::swap(board[blank], board[cell]);
+    blank = cell;
+  }
+  return board;
+}
+
+TEST_CASE("8 Puzzle distance table") {
+  Board goal = { 1, 2, 3, 4, 5, 6, 7, 8, 0 };
+  DistanceTable table{ 3, 3, goal };
+
+  SECTION("holds one byte per solvable board") {
+    REQUIRE(table.size_bytes() == 181440);
+    REQUIRE(table.distance(goal) == 0);
+    REQUIRE(table.max_distance() == 31);
+    REQUIRE(table.solve(goal).empty());
+  }
+
+  SECTION("solves the hardest instances optimally") {
+    Board hardest = { 8, 6, 7, 2, 5, 4, 3, 0, 1 };
+    REQUIRE(table.distance(hardest) == 31);
+    std::vector<int> moves = table.solve(hardest);
+    REQUIRE(moves.size() == 31);
+    REQUIRE(play(hardest, moves, 3) == goal);
+  }
+
+  SECTION("distances are exact and at least the pattern database's") {
+    PatternDatabase database{ 3, 3, goal, { { 1, 2, 3, 4 }, { 5, 6, 7, 8 } } };
+    srand(5);
+    for (int i = 0; i < 300; i++) {
+      Board board = random_walk(goal, 3, 3, 60);
+      int distance = table.distance(board);
+      REQUIRE(distance >= database.h(board));
+      REQUIRE(distance <= 31);
+      std::vector<int> moves = table.solve(board);
+      REQUIRE(int(moves.size()) == distance);
+      REQUIRE(play(board, moves, 3) == goal);
+    }
+  }
+
+  SECTION("rejects unsolvable boards") {
+    Board swapped = { 2, 1, 3, 4, 5, 6, 7, 8, 0 };
+    REQUIRE(!table.solvable(swapped));
+    REQUIRE(table.solvable(goal));
+    REQUIRE_THROWS_AS(table.solve(swapped), std::invalid_argument);
+  }
+
+  SECTION("rejects boards with bad tiles") {
+    REQUIRE_THROWS_AS(table.solve(Board{ 1, 2, 3, 4, 5, 6, 7, 8, 9 }), std::invalid_argument);
+    REQUIRE_THROWS_AS(table.solve(Board{ 1, 2, 3, 4, 5, 6, 7, 8, 100 }), std::invalid_argument);
+    REQUIRE_THROWS_AS(table.solve(Board{ 1, 2, 3, 4, 5, 6, 7, 8, -1 }), std::invalid_argument);
+    REQUIRE_THROWS_AS(table.solvable(Board{ 1, 2, 3, 4, 5, 6, 7, 8, 8 }), std::invalid_argument);
+  }
+
+  SECTION("survives a save, load and map round trip") {
+    std::string path = "distance_table_test.bin";
+    table.save(path);
+    DistanceTable loaded = DistanceTable::load(path);
+    DistanceTable mapped = DistanceTable::map(path);
+    std::remove(path.c_str());  // The mapping outlives the file name.
+
+    REQUIRE(!loaded.mapped());
+    REQUIRE(mapped.mapped());
+    REQUIRE(mapped.goal == goal);
+    DistanceTable copy = mapped;
+    srand(13);
+    for (int i = 0; i < 100; i++) {
+      Board board = random_walk(goal, 3, 3, 40);
+      REQUIRE(loaded.distance(board) == table.distance(board));
+      REQUIRE(copy.distance(board) == table.distance(board));
+      REQUIRE(mapped.solve(board) == table.solve(board));
+    }
+  }
+
+  SECTION("rejects files that are not tables") {
+    std::string path = "distance_table_test.bin";
+    PatternDatabase{ 3, 3, goal, { { 1, 2 } } }.save(path);
+    REQUIRE_THROWS_AS(DistanceTable::load(path), std::runtime_error);
+    REQUIRE_THROWS_AS(DistanceTable::map(path), std::runtime_error);
+    std::remove(path.c_str());
+    REQUIRE_THROWS_AS(DistanceTable::map(path), std::runtime_error);
+  }
+}
+
+TEST_CASE("Distance tables reject invalid goals") {
+  REQUIRE_THROWS_AS((DistanceTable{ 3, 3, { 0, 1, 2, 3, 4, 5, 6, 7, 7 } }), std::invalid_argument);
+  REQUIRE_THROWS_AS((DistanceTable{ 4, 4, Board(16, 0) }), std::invalid_argument);
+}
+
+TEST_CASE("2 x 3 Puzzle distance table") {
+  Board goal = { 1, 2, 3, 4, 5, 0 };
+  DistanceTable table{ 3, 2, goal };
+  REQUIRE(table.size_bytes() == 360);
+  REQUIRE(table.max_distance() == 21);  // The hardest 5 Puzzle instances.
+  srand(9);
+  for (int i = 0; i < 50; i++) {
+    Board board = random_walk(goal, 3, 2, 30);
+    REQUIRE(play(board, table.solve(board), 3) == goal);
+  }
+}
@@ -0,0 +1,156 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <random>
+
+// ---------------------------------------------------------------------------------
+// Random numbers
+
+/*
+ * Step of splitmix64: the generator used to expand a 64-bit seed into the
+ * state of a Random.
+ */
+inline uint64_t splitmix64(uint64_t& state) {
+  uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+  return z ^ (z >> 31);
+}
+
+/*
+ * Stream of random numbers (xoshiro256++): 32 bytes of state, a few cycles per
+ * number, and a period of 2^256 - 1. Also a UniformRandomBitGenerator, for the
+ * std distributions.
+ *
+ * Streams are reproducible from their seed. split() hands out streams 2^128
+ * numbers apart, so the streams of the threads of an algorithm never overlap and
+ * only depend on the seed and the order of the splits.
+ */
+struct Random {
+  using result_type = uint64_t;
+
+  explicit Random(uint64_t seed = 0) {
+    for (uint64_t& word : s) {
+      word = splitmix64(seed);
+    }
+  }
+
+  static constexpr result_type min() { return 0; }
+  static constexpr result_type max() { return std::numeric_limits<uint64_t>::max(); }
+
+  result_type operator()() {
+    uint64_t result = rotl(s[0] + s[3], 23) + s[0];
+    uint64_t t = s[1] << 17;
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rotl(s[3], 45);
+    return result;
+  }
+
+  /*
+   * Uniform integer in [0, n), n > 0, without modulo bias (Lemire's multiply and
+   * reject, which almost never rejects).
+   */
+  uint64_t below(uint64_t n) {
+    __uint128_t m = __uint128_t((*this)()) * n;
+    uint64_t low = uint64_t(m);
+    if (low < n) {
+      uint64_t threshold = -n % n;
+      while (low < threshold) {
+        m = __uint128_t((*this)()) * n;
+        low = uint64_t(m);
+      }
+    }
+    return uint64_t(m >> 64);
+  }
+
+  /*
+   * Uniform double in [0, 1), from the top 53 bits.
+   */
+  double uniform() {
+    return ((*this)() >> 11) * 0x1.0p-53;
+  }
+
+  /*
+   * True with probability p.
+   */
+  bool chance(double p) {
+    return uniform() < p;
+  }
+
+  /*
+   * Returns this stream, and moves this one 2^128 numbers ahead.
+   */
+  Random split() {
+    Random stream = *this;
+    jump();
+    return stream;
+  }
+
+  /*
+   * Advances the stream by 2^128 numbers.
+   */
+  void jump() {
+    static constexpr uint64_t polynomial[] = {
+      0x180EC6D33CFD0ABAull, 0xD5A61266F0C9392Cull, 0xA9582618E03FC9AAull, 0x39ABDC4529B1661Cull
+    };
+    uint64_t jumped[4] = {};
+    for (uint64_t word : polynomial) {
+      for (int bit = 0; bit < 64; bit++) {
+        if (word & (uint64_t(1) << bit)) {
+          for (int k = 0; k < 4; k++) {
+            jumped[k] ^= s[k];
+          }
+        }
+        (*this)();
+      }
+    }
+    for (int k = 0; k < 4; k++) {
+      s[k] = jumped[k];
+    }
+  }
+
+private:
+  static uint64_t rotl(uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+  }
+
+  uint64_t s[4];
+};
+
+inline std::atomic<uint64_t>& thread_random_seed() {
+  static std::atomic<uint64_t> seed{ (uint64_t(std::random_device{}()) << 32) | std::random_device{}() };
+  return seed;
+}
+
+inline std::atomic<uint64_t>& thread_random_count() {
+  static std::atomic<uint64_t> count{ 0 };
+  return count;
+}
+
+/*
+ * The stream of the calling thread, for callers that do not pass one. It is
+ * seeded from a process-wide seed (drawn once from random_device, unless
+ * seed_thread_random set it) and from the order in which threads first use it.
+ */
+inline Random& thread_random() {
+  thread_local Random stream{ [] {
+    uint64_t state = thread_random_seed().load() + thread_random_count()++;
+    return splitmix64(state);
+  }() };
+  return stream;
+}
+
+/*
+ * Reseeds the stream of the calling thread, and the seed of the streams of
+ * threads that did not draw yet. Makes the default streams reproducible.
+ */
+inline void seed_thread_random(uint64_t seed) {
+  thread_random_seed() = seed;
+  thread_random() = Random{ seed };
+}
@@ -1,9 +1,17 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
 #include <memory>
 #include <functional>
+#include <iterator>
+#include <limits>
+#include <type_traits>
 #include <stdexcept>
 #include <utility>
 #include <vector>
-#include <queue>
+
+#include "stats.cpp"
 
 // ---------------------------------------------------------------------------------
 // Problems and nodes
@@ -63,6 +71,9 @@ private:
  */
 template<typename S, typename A>
 struct Problem {
+  using state_type = S;
+  using action_type = A;
+
   Problem(S initial, S goal)
   : initial{ initial }, goal{ goal } {}
 
@@ -91,10 +102,58 @@ struct Problem {
     return 1;
   }
 
+  /*
+   * Writes the actions available in state to out, which has room for capacity
+   * actions, and returns their count. A count above capacity means they did not
+   * fit, and out is left unspecified.
+   *
+   * This default writes nothing and returns capacity + 1, which sends
+   * successors back to actions().
+   */
+  virtual size_t actions_into(const S& /* state */, A* /* out */, size_t capacity) const {
+    return capacity + 1;
+  }
+
+  /*
+   * Calls visit(action, state, cost) for every successor of state.
+   *
+   * The actions are collected on the stack by actions_into, so problems that
+   * override it allocate nothing per expansion, even when searched through
+   * Problem<S, A>; the others go through actions() and allocate its vector.
+   * Subclasses can also hide this with their own template that generates
+   * successors in place; search algorithms call it on the concrete problem
+   * type, so theirs is used.
+   */
+  template <typename Visitor>
+  void successors(const S& state, Visitor&& visit) const {
+    A buffer[max_buffered_actions];
+    size_t count = actions_into(state, buffer, max_buffered_actions);
+    if (count <= max_buffered_actions) {
+      for (size_t i = 0; i < count; i++) {
+        S new_state = result(state, buffer[i]);
+        visit(buffer[i], new_state, action_cost(state, buffer[i], new_state));
+      }
+      return;
+    }
+    for (const A& action : actions(state)) {
+      S new_state = result(state, action);
+      visit(action, new_state, action_cost(state, action, new_state));
+    }
+  }
+
+  static constexpr size_t max_buffered_actions = 16;
+
   /*
    * Heuristic function.
    */
   virtual double h(Node<S, A> node) const {
+    return h(node.state);
+  }
+
+  /*
+   * Heuristic function, estimated from the state alone.
+   */
+  virtual double h(const S& /* state */) const {
     return 0;
   }
 
@@ -113,20 +172,70 @@ struct Problem {
 private:
 };
 
+/*
+ * Statically dispatched counterpart of Problem, using CRTP.
+ *
+ * Search algorithms are templates on the problem type and only rely on the
+ * members below (plus actions and result, which Derived must define), so a
+ * problem deriving from StaticProblem has no virtual calls and its successor
+ * and heuristic functions can be inlined into the search loop. Problem<S, A>
+ * provides the same members as virtual functions, so it can be passed to the
+ * same algorithms, paying one indirect call per member.
+ */
+template <typename Derived, typename S, typename A>
+struct StaticProblem {
+  using state_type = S;
+  using action_type = A;
+
+  StaticProblem(S initial, S goal)
+  : initial{ initial }, goal{ goal } {}
+
+  bool is_goal(const S& state) const {
+    return state == goal;
+  }
+
+  double action_cost(const S& /* state_1 */, const A& /* action */, const S& /* state_2 */) const {
+    return 1;
+  }
+
+  /*
+   * Calls visit(action, state, cost) for every successor of state. As for
+   * Problem, Derived can define its own to avoid building the actions vector.
+   */
+  template <typename Visitor>
+  void successors(const S& state, Visitor&& visit) const {
+    for (const A& action : derived().actions(state)) {
+      S new_state = derived().result(state, action);
+      visit(action, new_state, derived().action_cost(state, action, new_state));
+    }
+  }
+
+  double h(const S& /* state */) const {
+    return 0;
+  }
+
+  double value(const S& state) const {
+    throw std::logic_error{ "Function not yet implemented" };
+  }
+
+  S initial;
+  S goal;
+protected:
+  const Derived& derived() const {
+    return static_cast<const Derived&>(*this);
+  }
+};
+
 /*
  * Expand a node, generating the children node.
  */
-template <typename S, typename A>
-std::vector<Node<S, A>> expand(Problem<S, A>& problem, std::shared_ptr<Node<S, A>> node) {
-  S s = node->state;
+template <typename P, typename S, typename A>
+std::vector<Node<S, A>> expand(const P& problem, std::shared_ptr<Node<S, A>> node) {
   std::vector<Node<S, A>> result;
 
-  for (const A& action : problem.actions(s)) {
-    S new_s = problem.result(s, action);
-    double cost = node->path_cost + problem.action_cost(node->state, action, new_s);
-    std::shared_ptr<Node<S, A>> parent = std::shared_ptr<Node<S, A>>(node);
-    result.emplace_back(new_s, action, parent, cost);
-  }
+  problem.successors(node->state, [&](const A& action, const S& new_s, double step_cost) {
+    result.emplace_back(new_s, action, node, node->path_cost + step_cost);
+  });
   return result;
 }
 /*
@@ -158,49 +267,483 @@ std::vector<S> path_states(Node<S, A> node) {
 }
 
 // ---------------------------------------------------------------------------------
-// Priority queue
+// Node arena
+
+/*
+ * Position of a node inside a NodeArena.
+ */
+using NodeIndex = uint32_t;
+
+/*
+ * Stands for "no node": the parent of a root, or a failed search.
+ */
+constexpr NodeIndex no_node = std::numeric_limits<NodeIndex>::max();
 
+/*
+ * A node in an arena-backed search tree.
+ *
+ * Same data as Node, but the parent is referenced by its index in the owning
+ * NodeArena, so linking a child costs neither an allocation nor a refcount.
+ */
 template <typename S, typename A>
-using KeyPair = std::pair<double, std::shared_ptr<Node<S, A>>>;
+struct SearchNode {
+  bool is_root() const {
+    return parent == no_node;
+  }
+
+  S state;
+  A action;
+  double path_cost;
+  int depth;
+  NodeIndex parent;
+};
+
+/*
+ * Pool of search nodes, stored in contiguous chunks of chunk_size nodes.
+ *
+ * Chunks never move, so a reference to a node stays valid while the arena
+ * grows. The whole tree is released at once with clear(), which keeps the
+ * chunks around so the arena can be reused by the next search.
+ */
+template <typename S, typename A>
+struct NodeArena {
+  static constexpr size_t chunk_bits = 12;
+  static constexpr size_t chunk_size = size_t{ 1 } << chunk_bits;
+
+  /*
+   * Adds a root node.
+   */
+  NodeIndex emplace(S state) {
+    return emplace(state, A{}, no_node, 0.0);
+  }
+
+  /*
+   * Adds a child of parent, reached through action.
+   */
+  NodeIndex emplace(S state, A action, NodeIndex parent, double path_cost) {
+    size_t chunk = count >> chunk_bits;
+    if (chunk == chunks.size()) {
+      chunks.emplace_back();
+      chunks.back().reserve(chunk_size);
+    }
+    int depth = parent == no_node ? 0 : (*this)[parent].depth + 1;
+    chunks[chunk].push_back(SearchNode<S, A>{ state, action, path_cost, depth, parent });
+    return static_cast<NodeIndex>(count++);
+  }
+
+  SearchNode<S, A>& operator[](NodeIndex index) {
+    return chunks[index >> chunk_bits][index & (chunk_size - 1)];
+  }
+
+  const SearchNode<S, A>& operator[](NodeIndex index) const {
+    return chunks[index >> chunk_bits][index & (chunk_size - 1)];
+  }
+
+  size_t size() const {
+    return count;
+  }
+
+  /*
+   * Memory held by the chunks.
+   */
+  size_t bytes() const {
+    size_t total = chunks.capacity() * sizeof(chunks[0]);
+    for (const auto& chunk : chunks) {
+      total += chunk.capacity() * sizeof(SearchNode<S, A>);
+    }
+    return total;
+  }
+
+  /*
+   * Forgets every node. Memory is kept for the next search.
+   */
+  void clear() {
+    for (auto& chunk : chunks) {
+      chunk.clear();
+    }
+    count = 0;
+  }
+
+  /*
+   * The sequence of actions to get to this node, starting from the root.
+   */
+  std::vector<A> path_actions(NodeIndex index) const {
+    std::vector<A> actions;
+    for (; !(*this)[index].is_root(); index = (*this)[index].parent) {
+      actions.push_back((*this)[index].action);
+    }
+    return std::vector<A>(actions.rbegin(), actions.rend());
+  }
+
+  /*
+   * The sequence of states to get to this node, starting from the root.
+   */
+  std::vector<S> path_states(NodeIndex index) const {
+    std::vector<S> states;
+    for (; index != no_node; index = (*this)[index].parent) {
+      states.push_back((*this)[index].state);
+    }
+    return std::vector<S>(states.rbegin(), states.rend());
+  }
+
+  /*
+   * Copies the path to this node into a shared_ptr Node chain, for callers of the
+   * Node based API. Costs one allocation per step of the path only.
+   */
+  std::shared_ptr<Node<S, A>> to_node(NodeIndex index) const {
+    const SearchNode<S, A>& node = (*this)[index];
+    if (node.is_root()) {
+      return std::make_shared<Node<S, A>>(node.state, node.path_cost);
+    }
+    return std::make_shared<Node<S, A>>(node.state, node.action, to_node(node.parent), node.path_cost);
+  }
+
+private:
+  std::vector<std::vector<SearchNode<S, A>>> chunks;
+  size_t count = 0;
+};
+
+// ---------------------------------------------------------------------------------
+// Reached set
+
+/*
+ * Hash for search states: std::hash for scalars, combined element-wise for
+ * containers (std::array, std::vector...) and pairs.
+ */
+template <typename T, typename = void>
+struct StateHash {
+  size_t operator()(const T& value) const {
+    return std::hash<T>{}(value);
+  }
+};
+
+template <typename T>
+struct StateHash<T, std::void_t<decltype(std::begin(std::declval<const T&>()))>> {
+  size_t operator()(const T& container) const {
+    size_t seed = 0;
+    for (const auto& element : container) {
+      seed ^= StateHash<std::decay_t<decltype(element)>>{}(element) + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2);
+    }
+    return seed;
+  }
+};
+
+template <typename T, typename U>
+struct StateHash<std::pair<T, U>> {
+  size_t operator()(const std::pair<T, U>& pair) const {
+    size_t seed = StateHash<T>{}(pair.first);
+    return seed ^ (StateHash<U>{}(pair.second) + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2));
+  }
+};
+
+/*
+ * SplitMix64 finalizer. Spreads weak hashes (std::hash of an integer is the
+ * identity) over every bit, so masking or reducing them modulo n stays uniform.
+ */
+inline uint64_t mix_hash(uint64_t x) {
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+  return x ^ (x >> 31);
+}
+
+/*
+ * A packer turns a state into the key it is stored under in the reached set, and
+ * names the hasher for that key. The identity packer keys states by themselves;
+ * problems with small states can supply a packer to a compact integer instead.
+ */
+template <typename S>
+struct IdentityPacker {
+  using key_type = S;
+  using hasher = StateHash<S>;
+
+  const S& operator()(const S& state) const {
+    return state;
+  }
+};
+
+/*
+ * The packer a search uses by default for problem type P: P::packer if the
+ * problem names one, IdentityPacker otherwise.
+ */
+template <typename P, typename = void>
+struct packer_of {
+  using type = IdentityPacker<typename P::state_type>;
+};
+
+template <typename P>
+struct packer_of<P, std::void_t<typename P::packer>> {
+  using type = typename P::packer;
+};
+
+template <typename P>
+using packer_of_t = typename packer_of<P>::type;
+
+/*
+ * Open-addressing (linear probing) hash table from packed states to node
+ * indexes. Keys and values share a slot, so a lookup usually costs a single
+ * cache miss. clear() keeps the slots for reuse.
+ */
+template <typename Key, typename Hash = StateHash<Key>>
+struct ReachedTable {
+  ReachedTable(size_t capacity = 1024) {
+    size_t n = 16;
+    while (n < capacity) {
+      n <<= 1;
+    }
+    slots.assign(n, Slot{ Key{}, no_node });
+  }
+
+  /*
+   * Returns the node stored under key, or no_node if key was never reached.
+   */
+  NodeIndex find(const Key& key) const {
+    return slots[probe(key)].node;
+  }
+
+  /*
+   * Returns a reference to the node stored under key, inserting key (with
+   * no_node) if it is not there yet. Valid until the next insertion.
+   */
+  NodeIndex& find_or_insert(const Key& key) {
+    if ((count + 1) * 4 > slots.size() * 3) {
+      grow();
+    }
+    Slot& slot = slots[probe(key)];
+    if (slot.node == no_node) {
+      slot.key = key;
+      count++;
+    }
+    return slot.node;
+  }
+
+  size_t size() const {
+    return count;
+  }
+
+  size_t bytes() const {
+    return slots.capacity() * sizeof(Slot);
+  }
+
+  void clear() {
+    for (Slot& slot : slots) {
+      slot.node = no_node;
+    }
+    count = 0;
+  }
+
+private:
+  struct Slot {
+    Key key;
+    NodeIndex node;
+  };
+
+  /*
+   * Index of the slot holding key, or of the empty slot where it would go.
+   */
+  size_t probe(const Key& key) const {
+    size_t mask = slots.size() - 1;
+    size_t i = mix_hash(hash(key)) & mask;
+    while (slots[i].node != no_node && !(slots[i].key == key)) {
+      i = (i + 1) & mask;
+    }
+    return i;
+  }
+
+  void grow() {
+    std::vector<Slot> old(slots.size() * 2, Slot{ Key{}, no_node });
+    old.swap(slots);
+    for (const Slot& slot : old) {
+      if (slot.node != no_node) {
+        slots[probe(slot.key)] = slot;
+      }
+    }
+  }
+
+  std::vector<Slot> slots;
+  size_t count = 0;
+  Hash hash;
+};
+
+// ---------------------------------------------------------------------------------
+// Priority queue
 
 template <typename S, typename A>
 using ToDouble = std::function<double(const Node<S, A>&)>;
 
 template <typename S, typename A>
-struct PriorityQueue {
-  PriorityQueue(std::vector<std::shared_ptr<Node<S, A>>> items, ToDouble<S, A> f)
-    : f{ f }, pq{} {
-    for (std::shared_ptr<Node<S, A>> item : items) {
-      push(item);
+using ArenaToDouble = std::function<double(const SearchNode<S, A>&)>;
+
+/*
+ * The A* evaluation function, f(n) = g(n) + h(n), as a concrete type rather
+ * than an ArenaToDouble so the search loop can inline the problem's heuristic.
+ */
+template <typename P>
+struct AStarPriority {
+  double operator()(const SearchNode<typename P::state_type, typename P::action_type>& node) const {
+    return node.path_cost + problem.h(node.state);
+  }
+
+  const P& problem;
+};
+
+/*
+ * Indexed D-ary min-heap of node indexes.
+ *
+ * Every node is in the heap at most once: position remembers where each node
+ * sits, so a cheaper path updates the node's key in place (decrease_key) instead
+ * of pushing a duplicate, and contains() tells frontier nodes apart from closed
+ * ones. A 4-ary heap is shallower than a binary one and its children share a
+ * cache line.
+ */
+template <size_t D = 4>
+struct IndexedHeap {
+  static_assert(D >= 2, "A heap needs at least two children per node");
+
+  void push(NodeIndex item, double key) {
+    if (item >= position.size()) {
+      position.resize(std::max<size_t>(item + 1, position.size() * 2), no_node);
     }
+    position[item] = static_cast<NodeIndex>(heap.size());
+    heap.push_back(Entry{ key, item });
+    sift_up(heap.size() - 1);
   }
 
-  void push(std::shared_ptr<Node<S, A>> item) { 
-    KeyPair<S, A> new_elem{ f(*item), item };
-    pq.push(new_elem);
+  /*
+   * Lowers the key of an item that is in the heap.
+   */
+  void decrease_key(NodeIndex item, double key) {
+    size_t i = position[item];
+    heap[i].key = key;
+    sift_up(i);
   }
 
-  std::shared_ptr<Node<S, A>> pop() {
-    auto item = pq.top().second;
-    pq.pop();
+  NodeIndex pop() {
+    NodeIndex item = heap.front().item;
+    position[item] = no_node;
+    Entry last = heap.back();
+    heap.pop_back();
+    if (!heap.empty()) {
+      heap.front() = last;
+      position[last.item] = 0;
+      sift_down(0);
+    }
     return item;
   }
 
-  std::shared_ptr<Node<S, A>> top() {
-    return pq.top().second;
+  NodeIndex top() const {
+    return heap.front().item;
+  }
+
+  double top_key() const {
+    return heap.front().key;
+  }
+
+  bool contains(NodeIndex item) const {
+    return item < position.size() && position[item] != no_node;
   }
 
   operator bool() const {
-    return !pq.empty();
+    return !heap.empty();
   }
 
   size_t len() const {
-    return pq.size();
+    return heap.size();
+  }
+
+  size_t bytes() const {
+    return heap.capacity() * sizeof(Entry) + position.capacity() * sizeof(NodeIndex);
+  }
+
+  /*
+   * Empties the heap, keeping its memory.
+   */
+  void clear() {
+    for (const Entry& entry : heap) {
+      position[entry.item] = no_node;
+    }
+    heap.clear();
   }
 
 private:
-  std::priority_queue<KeyPair<S, A>> pq;
-  ToDouble<S, A> f;
+  struct Entry {
+    double key;
+    NodeIndex item;
+  };
+
+  void place(size_t i, Entry entry) {
+    heap[i] = entry;
+    position[entry.item] = static_cast<NodeIndex>(i);
+  }
+
+  void sift_up(size_t i) {
+    Entry entry = heap[i];
+    while (i > 0) {
+      size_t parent = (i - 1) / D;
+      if (!(entry.key < heap[parent].key)) {
+        break;
+      }
+      place(i, heap[parent]);
+      i = parent;
+    }
+    place(i, entry);
+  }
+
+  void sift_down(size_t i) {
+    Entry entry = heap[i];
+    size_t n = heap.size();
+    while (true) {
+      size_t first = i * D + 1;
+      if (first >= n) {
+        break;
+      }
+      size_t best = first;
+      size_t last = std::min(first + D, n);
+      for (size_t child = first + 1; child < last; child++) {
+        if (heap[child].key < heap[best].key) {
+          best = child;
+        }
+      }
+      if (!(heap[best].key < entry.key)) {
+        break;
+      }
+      place(i, heap[best]);
+      i = best;
+    }
+    place(i, entry);
+  }
+
+  std::vector<Entry> heap;
+  std::vector<NodeIndex> position;
 };
 
+// ---------------------------------------------------------------------------------
+// Search context
+
+/*
+ * Everything a best-first search allocates: the node arena, the reached set and
+ * the frontier. Each search clears them but keeps their memory, so a context
+ * reused across searches (one per thread, say) stops allocating once it has
+ * grown to the size of the largest search. The search leaves its statistics in
+ * stats.
+ */
+template <typename S, typename A, typename Packer = IdentityPacker<S>>
+struct SearchContext {
+  SearchContext(Packer pack = {}) : pack{ pack } {}
+
+  void clear() {
+    arena.clear();
+    reached.clear();
+    frontier.clear();
+    stats = {};
+  }
 
+  size_t bytes() const {
+    return arena.bytes() + reached.bytes() + frontier.bytes();
+  }
+
+  NodeArena<S, A> arena;
+  ReachedTable<typename Packer::key_type, typename Packer::hasher> reached;
+  IndexedHeap<> frontier;
+  Packer pack;
+  SearchStats stats;  // Of the last search.
+};
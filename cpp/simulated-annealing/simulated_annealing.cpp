@@ -1,3 +1,5 @@
+#pragma once
+
 #include <algorithm>
 #include <cstdio>
 #include <iostream>
@@ -8,10 +10,13 @@
 #include <functional>
 #include <cmath>
 #include <map>
+#include <type_traits>
 #include <assert.h>
 
 #include "../search.cpp"
+#include "../stats.cpp"
 #include "../utils.cpp"
+#include "../concurrency.cpp"
 
 // ---------------------------------------------------------------------------------
 // Utilities.
@@ -29,36 +34,259 @@ ScheduleFunction exp_schedule(int k = 20, double lam = 0.005, int limit = 100) {
 // ---------------------------------------------------------------------------------
 // Algorithm
 
+/*
+ * True when P draws a random successor itself: random_successor(state, next&,
+ * random) returning false when state has none, as PeakFindingProblem does.
+ */
+template <typename P, typename = void>
+struct draws_successors : std::false_type {};
+
+template <typename P>
+struct draws_successors<P, std::void_t<
+  decltype(bool(std::declval<const P&>().random_successor(
+    std::declval<const typename P::state_type&>(), std::declval<typename P::state_type&>(), std::declval<Random&>())))
+>> : std::true_type {};
+
+/*
+ * Draws one successor of state, uniformly, into next. Returns false if state has
+ * no successor. Problems that draw successors themselves (see draws_successors)
+ * do it directly; for the others, reservoir sampling over problem.successors
+ * generates every successor, but allocates nothing.
+ */
+template <typename P>
+bool random_successor(const P& problem, const typename P::state_type& state, typename P::state_type& next, Random& random) {
+  using S = typename P::state_type;
+  using A = typename P::action_type;
+
+  if constexpr (draws_successors<P>::value) {
+    return problem.random_successor(state, next, random);
+  } else {
+    size_t seen = 0;
+    problem.successors(state, [&](const A&, const S& child, double) {
+      if (random.below(++seen) == 0) {
+        next = child;
+      }
+    });
+    return seen > 0;
+  }
+}
+
+/*
+ * What an annealing did: steps taken (successors drawn), accepted moves, and
+ * among them the moves to a better state.
+ */
+struct AnnealingStats {
+  double acceptance_rate() const {
+    return steps.value() ? double(accepted.value()) / steps.value() : 0;
+  }
+
+  Counter steps;
+  Counter accepted;
+  Counter improving;
+  PhaseTimes phases;
+};
+
+inline void write_json(std::ostream& out, const AnnealingStats& stats) {
+  JsonObject json{ out };
+  json.field("enabled", stats_enabled)
+    .field("steps", stats.steps)
+    .field("accepted", stats.accepted)
+    .field("improving", stats.improving)
+    .field("acceptance_rate", stats.acceptance_rate())
+    .field("phases", stats.phases);
+}
+
 /*
  * Initializes a random solution using a variable T (for temperature) which
  * is updated randomly. In case the update has better cost, it is selected,
  * otherwise it's selected with a probability p.
  * 
  * Moving to worst solutions can help to get closer to global optimal solutions.
+ * Every random draw comes from random, and the statistics of the run are copied
+ * to *stats, if given.
+ *
+ * Each step evaluates a single successor, drawn by random_successor: in constant
+ * time when the problem draws it itself, otherwise after generating all of
+ * them. The current state is kept by value with its value cached, so a step
+ * allocates nothing.
  */
-template <typename S, typename A>
-S simulated_annealing(Problem<S, A>& problem, ScheduleFunction schedule = exp_schedule()) {
-  std::shared_ptr<Node<S, A>> current = std::make_shared<Node<S, A>>(problem.initial);
-  for (size_t t{}; t < std::numeric_limits<size_t>::max(); t++) {
-    double T = schedule(t);
-
-    if (T == 0) {
-      return current->state;
+template <typename P, typename Schedule = ScheduleFunction>
+typename P::state_type simulated_annealing(
+  const P& problem,
+  Schedule schedule = exp_schedule(),
+  Random& random = thread_random(),
+  AnnealingStats* stats = nullptr
+) {
+  using S = typename P::state_type;
+
+  AnnealingStats run;
+  S current = problem.initial;
+  {
+    PhaseTimer timer{ run.phases, "anneal" };
+    double current_value = problem.value(current);
+    S next = current;
+    for (size_t t{}; t < std::numeric_limits<size_t>::max(); t++) {
+      double T = schedule(t);
+
+      if (T == 0 || !random_successor(problem, current, next, random)) {
+        break;
+      }
+      ++run.steps;
+
+      double next_value = problem.value(next);
+      double delta_e = next_value - current_value;
+      if (delta_e > 0 || probability(std::exp(delta_e / T), random)) {
+        ++run.accepted;
+        if (delta_e > 0) {
+          ++run.improving;
+        }
+        std::swap(current, next);
+        current_value = next_value;
+      }
     }
+  }
+  if (stats) {
+    *stats = run;
+  }
+  return current;
+}
+
+// ---------------------------------------------------------------------------------
+// Parallel annealing
+
+/*
+ * Runs restarts independent annealings on the pool and returns the final state
+ * of highest value (the earliest restart on ties). Restart k draws from the k-th
+ * stream split from Random(seed), so the result only depends on seed.
+ */
+template <typename P, typename Schedule = ScheduleFunction>
+typename P::state_type multi_start_annealing(
+  const P& problem,
+  size_t restarts,
+  ThreadPool& pool,
+  uint64_t seed = 0,
+  Schedule schedule = exp_schedule()
+) {
+  using S = typename P::state_type;
+
+  Random root{ seed };
+  std::vector<Random> streams;
+  for (size_t k = 0; k < restarts; k++) {
+    streams.push_back(root.split());
+  }
+
+  std::vector<S> finals(restarts, problem.initial);
+  std::vector<double> values(restarts);
+  pool.parallel_for(0, restarts, [&](size_t k) {
+    finals[k] = simulated_annealing(problem, schedule, streams[k]);
+    values[k] = problem.value(finals[k]);
+  });
+
+  size_t best = std::max_element(values.begin(), values.end()) - values.begin();
+  return restarts > 0 ? finals[best] : problem.initial;
+}
+
+/*
+ * count temperatures from coldest to hottest, in geometric progression.
+ */
+inline std::vector<double> geometric_temperatures(double coldest, double hottest, size_t count) {
+  std::vector<double> temperatures;
+  for (size_t k = 0; k < count; k++) {
+    double fraction = count > 1 ? double(k) / (count - 1) : 0;
+    temperatures.push_back(coldest * std::pow(hottest / coldest, fraction));
+  }
+  return temperatures;
+}
+
+template <typename S>
+struct TemperingResult {
+  S best;                 // Highest value seen by any replica.
+  double best_value = 0;
+  size_t swaps_attempted = 0;
+  size_t swaps_accepted = 0;
+};
+
+/*
+ * Parallel tempering (replica exchange): one replica per temperature, all
+ * starting at the initial state, runs Metropolis steps at its fixed temperature
+ * on the pool. Every swap_interval steps, neighbouring replicas (alternately the
+ * even and the odd pairs) exchange their states with probability
+ * min(1, exp((v_j - v_i) (1 / T_i - 1 / T_j))), which lets good states found
+ * while hot move down the ladder to be refined.
+ *
+ * Runs rounds * swap_interval steps per replica. Each replica and the swaps draw
+ * from their own streams split from Random(seed), so runs are reproducible.
+ */
+template <typename P>
+TemperingResult<typename P::state_type> parallel_tempering(
+  const P& problem,
+  const std::vector<double>& temperatures,
+  size_t rounds,
+  size_t swap_interval,
+  ThreadPool& pool,
+  uint64_t seed = 0
+) {
+  using S = typename P::state_type;
+
+  struct Replica {
+    S state;
+    double value;
+    S next;
+    S best;
+    double best_value;
+    Random random;
+  };
+
+  Random root{ seed };
+  Random swaps = root.split();
+  double initial_value = problem.value(problem.initial);
+  std::vector<Replica> replicas;
+  for (size_t k = 0; k < temperatures.size(); k++) {
+    replicas.push_back(Replica{ problem.initial, initial_value, problem.initial, problem.initial, initial_value, root.split() });
+  }
 
-    std:std::vector<Node<S, A>> neighbors = expand(problem, current);
+  TemperingResult<S> result{ problem.initial, initial_value };
+  for (size_t round = 0; round < rounds; round++) {
+    pool.parallel_for(0, replicas.size(), [&](size_t k) {
+      Replica& replica = replicas[k];
+      double T = temperatures[k];
+      for (size_t step = 0; step < swap_interval; step++) {
+        if (!random_successor(problem, replica.state, replica.next, replica.random)) {
+          break;
+        }
+        double next_value = problem.value(replica.next);
+        double delta_e = next_value - replica.value;
+        if (delta_e > 0 || replica.random.chance(std::exp(delta_e / T))) {
+          std::swap(replica.state, replica.next);
+          replica.value = next_value;
+          if (replica.value > replica.best_value) {
+            replica.best = replica.state;
+            replica.best_value = replica.value;
+          }
+        }
+      }
+    });
 
-    if (neighbors.empty()) {
-      return current->state;
+    for (size_t i = round % 2; i + 1 < replicas.size(); i += 2) {
+      Replica& cold = replicas[i];
+      Replica& hot = replicas[i + 1];
+      double exponent = (hot.value - cold.value) * (1 / temperatures[i] - 1 / temperatures[i + 1]);
+      result.swaps_attempted++;
+      if (exponent >= 0 || swaps.chance(std::exp(exponent))) {
+        std::swap(cold.state, hot.state);
+        std::swap(cold.value, hot.value);
+        result.swaps_accepted++;
+      }
     }
+  }
 
-    Node<S, A> next_choice = random_choice<Node<S, A>>(neighbors);
-    double delta_e = problem.value(next_choice.state) - problem.value(current->state);
-    if (delta_e > 0 || probability(std::exp(delta_e / T))) {
-      current = std::make_shared<Node<S, A>>(next_choice);
+  for (const Replica& replica : replicas) {
+    if (replica.best_value > result.best_value) {
+      result.best = replica.best;
+      result.best_value = replica.best_value;
     }
-  } 
-  return current->state;
+  }
+  return result;
 }
 
 // ---------------------------------------------------------------------------------
@@ -99,7 +327,7 @@ ActionTable directions8() {
  *
  * The grid is a 2-dimensional array/list whose state is specified by an index.
  */
-struct PeakFindingProblem : Problem<Index2D, Direction> {
+struct PeakFindingProblem final : Problem<Index2D, Direction> {
   PeakFindingProblem(
       Index2D initial,
       Grid grid,
@@ -108,7 +336,8 @@ struct PeakFindingProblem : Problem<Index2D, Direction> {
       grid{ grid },
       defined_actions{ defined_actions },
       n{ grid.size() },
-      m{ grid[0].size() } {}
+      m{ grid[0].size() },
+      moves(defined_actions.begin(), defined_actions.end()) {}
 
   /*
    * Returns the vector of actions which are allowed to be taken from the given
@@ -125,6 +354,52 @@ struct PeakFindingProblem : Problem<Index2D, Direction> {
     return allowed_actions;
   }
 
+  size_t actions_into(const Index2D& state, Direction* out, size_t capacity) const override {
+    size_t count = 0;
+    for (const auto& [action, movement] : moves) {
+      if (valid_state(pair_sum(state, movement))) {
+        if (count < capacity) {
+          out[count] = action;
+        }
+        count++;
+      }
+    }
+    return count;
+  }
+
+  /*
+   * Calls visit(action, state, cost) for every neighbor inside the grid, without
+   * building the actions vector.
+   */
+  template <typename Visitor>
+  void successors(const Index2D state, Visitor&& visit) const {
+    for (const auto& [action, movement] : moves) {
+      Index2D next_state = pair_sum(state, movement);
+      if (valid_state(next_state)) {
+        visit(action, next_state, 1.0);
+      }
+    }
+  }
+
+  /*
+   * Draws one neighbor inside the grid, uniformly, into next: draws one of the
+   * moves, again while it leaves the grid. Returns false if every move does.
+   */
+  bool random_successor(const Index2D state, Index2D& next, Random& random) const {
+    for (size_t draws = 1; !moves.empty(); draws++) {
+      next = pair_sum(state, moves[random.below(moves.size())].second);
+      if (valid_state(next)) {
+        return true;
+      }
+      if (draws % moves.size() == 0 && std::none_of(moves.begin(), moves.end(), [&](const auto& move) {
+            return valid_state(pair_sum(state, move.second));
+          })) {
+        return false;
+      }
+    }
+    return false;
+  }
+
   /*
    * Moves in the direction specified by action.
    */
@@ -152,6 +427,7 @@ struct PeakFindingProblem : Problem<Index2D, Direction> {
   size_t n, m;
   ActionTable defined_actions;
   Grid grid;
+  std::vector<std::pair<Direction, Index2D>> moves;  // defined_actions, flat for successors.
 };
 
 void imprimirSols(const std::vector<double>& sols) {
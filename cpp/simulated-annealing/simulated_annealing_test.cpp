@@ -49,3 +49,145 @@ TEST_CASE("Simmulated annealing") {
     REQUIRE(*max == Approx(999));
   }
 }
+
+TEST_CASE("Simulated annealing is reproducible from its stream") {
+  PeakFindingProblem prob{
+    {0, 0},
+    {{ 0, 5, 10, 8},
+     {-3, 7, 9,  999},
+     { 1, 2, 5,  11}},
+    directions8()
+  };
+  for (uint64_t seed : {1, 2, 3}) {
+    Random random{ seed }, same{ seed };
+    REQUIRE(simulated_annealing(prob, exp_schedule(), random) == simulated_annealing(prob, exp_schedule(), same));
+  }
+}
+
+TEST_CASE("Simulated annealing counts its moves") {
+  PeakFindingProblem prob{
+    {0, 0},
+    {{ 0, 5, 10, 8},
+     {-3, 7, 9,  999},
+     { 1, 2, 5,  11}},
+    directions8()
+  };
+  Random random{ 7 };
+  AnnealingStats stats;
+  simulated_annealing(prob, exp_schedule(), random, &stats);
+  if (stats_enabled) {
+    REQUIRE(stats.steps.value() == 100);  // The schedule reaches 0 at t = 100.
+    REQUIRE(stats.accepted.value() <= stats.steps.value());
+    REQUIRE(stats.improving.value() <= stats.accepted.value());
+    REQUIRE(stats.acceptance_rate() == Approx(stats.accepted.value() / 100.0));
+  }
+  REQUIRE(to_json(stats).find("\"acceptance_rate\":") != std::string::npos);
+}
+
+TEST_CASE("Peak finding successors stay inside the grid") {
+  PeakFindingProblem prob{
+    {0, 0},
+    {{ 0, 5, 10},
+     {-3, 7, 11},
+     { 1, 2, 5}},
+    directions8()
+  };
+
+  std::vector<Index2D> corner;
+  prob.successors({0, 0}, [&](Direction /* action */, const Index2D& state, double /* cost */) {
+    corner.push_back(state);
+  });
+  REQUIRE(corner.size() == 3);
+
+  std::vector<Index2D> center;
+  prob.successors({1, 1}, [&](Direction action, const Index2D& state, double /* cost */) {
+    REQUIRE(state == prob.result({1, 1}, action));
+    center.push_back(state);
+  });
+  REQUIRE(center.size() == 8);
+}
+
+TEST_CASE("Random successors are drawn uniformly from the grid") {
+  PeakFindingProblem prob{
+    {0, 0},
+    {{ 0, 5, 10},
+     {-3, 7, 11},
+     { 1, 2, 5}},
+    directions8()
+  };
+  Random random{ 4 };
+  std::map<Index2D, int> counts;
+  Index2D next;
+  bool sampled = true;
+  for (int k = 0; k < 80000; k++) {
+    sampled &= random_successor(prob, {1, 1}, next, random);
+    counts[next]++;
+  }
+  REQUIRE(sampled);
+  REQUIRE(counts.size() == 8);
+  for (const auto& [state, count] : counts) {
+    REQUIRE(count == Approx(10000).margin(500));
+  }
+
+  counts.clear();
+  for (int k = 0; k < 30000; k++) {
+    sampled &= random_successor(prob, {0, 0}, next, random);
+    counts[next]++;
+  }
+  REQUIRE(sampled);
+  REQUIRE(counts.size() == 3);
+  for (const auto& [state, count] : counts) {
+    REQUIRE(count == Approx(10000).margin(500));
+  }
+
+  // Problem has no random_successor of its own: sampled from its successors.
+  const Problem<Index2D, Direction>& base = prob;
+  counts.clear();
+  for (int k = 0; k < 30000; k++) {
+    sampled &= random_successor(base, {0, 0}, next, random);
+    counts[next]++;
+  }
+  REQUIRE(sampled);
+  REQUIRE(counts.size() == 3);
+  for (const auto& [state, count] : counts) {
+    REQUIRE(count == Approx(10000).margin(500));
+  }
+
+  PeakFindingProblem single{ {0, 0}, {{ 42 }} };
+  REQUIRE_FALSE(random_successor(single, {0, 0}, next, random));
+  REQUIRE(simulated_annealing(single) == Index2D{0, 0});
+}
+
+TEST_CASE("Parallel annealing") {
+  PeakFindingProblem prob{
+    {0, 0},
+    {{ 0, 5, 10, 8},
+     {-3, 7, 9,  999},
+     { 1, 2, 5,  11}},
+    directions8()
+  };
+  ThreadPool pool(4);
+
+  SECTION("multi-start returns the best restart") {
+    Index2D best = multi_start_annealing(prob, 100, pool, 7);
+    REQUIRE(prob.value(best) == Approx(999));
+    REQUIRE(multi_start_annealing(prob, 100, pool, 7) == best);
+  }
+
+  SECTION("tempering finds the peak") {
+    std::vector<double> ladder = geometric_temperatures(0.5, 500, 6);
+    REQUIRE(ladder.front() == Approx(0.5));
+    REQUIRE(ladder.back() == Approx(500));
+    REQUIRE(ladder[1] / ladder[0] == Approx(ladder[5] / ladder[4]));
+
+    TemperingResult<Index2D> result = parallel_tempering(prob, ladder, 50, 20, pool, 3);
+    REQUIRE(result.best_value == Approx(999));
+    REQUIRE(prob.value(result.best) == Approx(999));
+    REQUIRE(result.swaps_attempted == 50 * 5 / 2);
+    REQUIRE(result.swaps_accepted > 0);
+
+    TemperingResult<Index2D> again = parallel_tempering(prob, ladder, 50, 20, pool, 3);
+    REQUIRE(again.best == result.best);
+    REQUIRE(again.swaps_accepted == result.swaps_accepted);
+  }
+}
@@ -0,0 +1,231 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstdlib>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+#include "../a-star/a_star.cpp"
+
+// ---------------------------------------------------------------------------------
+// Sliding-tile puzzles of any size
+
+/*
+ * A W x H board. Besides the tiles (row-major, 0 is the blank), a state caches
+ * the blank's cell and the Manhattan distance to the goal, which moves update
+ * in O(1) instead of rescanning the board.
+ */
+template <int W, int H>
+struct TileState {
+  bool operator==(const TileState<W, H>& other) const {
+    return tiles == other.tiles;
+  }
+
+  bool operator<(const TileState<W, H>& other) const {
+    return tiles < other.tiles;
+  }
+
+  std::array<uint8_t, W * H> tiles;
+  uint8_t blank;
+  uint16_t h;
+};
+
+/*
+ * Key of a state in the reached set: one nibble per tile when the board has at
+ * most 16 cells, the tile array itself otherwise.
+ */
+template <int W, int H>
+struct TilePacker {
+  using key_type = std::conditional_t<(W * H <= 16), uint64_t, std::array<uint8_t, W * H>>;
+  using hasher = StateHash<key_type>;
+
+  key_type operator()(const TileState<W, H>& state) const {
+    if constexpr (W * H <= 16) {
+      uint64_t key = 0;
+      for (int cell = 0; cell < W * H; cell++) {
+        key |= uint64_t(state.tiles[cell]) << (4 * cell);
+      }
+      return key;
+    } else {
+      return state.tiles;
+    }
+  }
+};
+
+/*
+ * The (W * H - 1)-puzzle: slide tiles into the blank until the goal is reached.
+ *
+ * Actions move the blank, as in EightPuzzle. The heuristic is the cached
+ * Manhattan distance, or a pattern database when one is set.
+ */
+template <int W, int H>
+struct SlidingTile : StaticProblem<SlidingTile<W, H>, TileState<W, H>, Actions> {
+  static_assert(W >= 2 && H >= 2 && W * H <= 64, "Unsupported board size");
+
+  static constexpr int cells = W * H;
+  using State = TileState<W, H>;
+  using Board = std::array<int, cells>;
+  using packer = TilePacker<W, H>;
+
+  SlidingTile(const Board& initial, const Board& goal)
+  : StaticProblem<SlidingTile<W, H>, State, Actions>{ State{}, State{} } {
+    if (!holds_every_tile(goal)) {
+      throw std::invalid_argument{ "Goal must hold every tile exactly once" };
+    }
+    for (int cell = 0; cell < cells; cell++) {
+      goal_cell[goal[cell]] = cell;
+    }
+    for (int tile = 0; tile < cells; tile++) {
+      for (int cell = 0; cell < cells; cell++) {
+        distance[tile][cell] = tile == 0 ? 0 : std::abs(cell / W - goal_cell[tile] / W) + std::abs(cell % W - goal_cell[tile] % W);
+      }
+    }
+    this->goal = make_state(goal);
+    this->initial = make_state(initial);
+  }
+
+  /*
+   * Builds a state from its tiles, computing the blank and h from scratch.
+   * Throws invalid_argument if board does not hold every tile exactly once.
+   */
+  State make_state(const Board& board) const {
+    if (!holds_every_tile(board)) {
+      throw std::invalid_argument{ "Board must hold every tile exactly once" };
+    }
+    State state{};
+    for (int cell = 0; cell < cells; cell++) {
+      state.tiles[cell] = board[cell];
+      state.h += distance[board[cell]][cell];
+      if (board[cell] == 0) {
+        state.blank = cell;
+      }
+    }
+    return state;
+  }
+
+  static bool holds_every_tile(const Board& board) {
+    std::array<bool, cells> seen{};
+    for (int tile : board) {
+      if (tile < 0 || tile >= cells || seen[tile]) {
+        return false;
+      }
+      seen[tile] = true;
+    }
+    return true;
+  }
+
+  bool is_goal(const State& state) const {
+    return state.h == 0;  // Every tile, and so the blank, is in place.
+  }
+
+  double h(const State& state) const {
+    if (pattern_database) {
+      return pattern_database->h(state.tiles);
+    }
+    return state.h;
+  }
+
+  std::vector<Actions> actions(const State& state) const {
+    std::vector<Actions> possible_actions;
+    possible_actions.reserve(4);
+    for_each_action(state, [&](Actions action) {
+      possible_actions.push_back(action);
+    });
+    return possible_actions;
+  }
+
+  State result(State state, Actions action) const {
+    apply(state, action);
+    return state;
+  }
+
+  template <typename Visitor>
+  void successors(const State& state, Visitor&& visit) const {
+    for_each_action(state, [&](Actions action) {
+      State child = state;
+      visit(action, child, apply(child, action));
+    });
+  }
+
+  /*
+   * Calls visit with every action allowed in state.
+   */
+  template <typename Visitor>
+  void for_each_action(const State& state, Visitor&& visit) const {
+    int row = state.blank / W;
+    int col = state.blank % W;
+    if (row > 0) visit(UP);
+    if (row < H - 1) visit(DOWN);
+    if (col > 0) visit(LEFT);
+    if (col < W - 1) visit(RIGHT);
+  }
+
+  /*
+   * Moves the blank in place. Only the tile that slides changes h. Returns the
+   * cost of the move.
+   */
+  double apply(State& state, Actions action) const {
+    int blank = state.blank;
+    int cell = blank + offset(action);
+    uint8_t tile = state.tiles[cell];
+    state.h = state.h - distance[tile][cell] + distance[tile][blank];
+    state.tiles[blank] = tile;
+    state.tiles[cell] = 0;
+    state.blank = cell;
+    return 1;
+  }
+
+  /*
+   * Takes back apply(state, action).
+   */
+  void undo(State& state, Actions action) const {
+    apply(state, inverse(action));
+  }
+
+  static Actions inverse(Actions action) {
+    switch (action) {
+      case UP:   return DOWN;
+      case DOWN: return UP;
+      case LEFT: return RIGHT;
+      default:   return LEFT;
+    }
+  }
+
+  /*
+   * A move is a transposition of the blank with a tile and moves the blank by one
+   * cell, so the parity of the permutation from state to goal always equals the
+   * parity of the blank's distance to its goal cell. This holds for any board
+   * size, and is also sufficient for the goal to be reachable.
+   */
+  bool is_solvable(const State& state) const {
+    std::array<bool, cells> visited{};
+    int transpositions = 0;
+    for (int cell = 0; cell < cells; cell++) {
+      for (int length = 0, next = cell; !visited[next]; length++) {
+        visited[next] = true;
+        next = goal_cell[state.tiles[next]];
+        transpositions += length > 0;
+      }
+    }
+    int blank_goal = goal_cell[0];
+    int blank_distance = std::abs(state.blank / W - blank_goal / W) + std::abs(state.blank % W - blank_goal % W);
+    return transpositions % 2 == blank_distance % 2;
+  }
+
+  const PatternDatabase* pattern_database = nullptr;
+
+private:
+  static int offset(Actions action) {
+    switch (action) {
+      case UP:   return -W;
+      case DOWN: return W;
+      case LEFT: return -1;
+      default:   return 1;
+    }
+  }
+
+  std::array<uint8_t, cells> goal_cell;
+  std::array<std::array<uint8_t, cells>, cells> distance;  // Manhattan distance of a tile at a cell.
+};
@@ -0,0 +1,125 @@
+#define CATCH_CONFIG_MAIN
+#include "../catch.hpp"
+#include "sliding_tile.cpp"
+
+/*
+ * Makes steps random moves from state.
+ */
+template <int W, int H>
+TileState<W, H> random_walk(const SlidingTile<W, H>& puzzle, TileState<W, H> state, int steps) {
+  for (int step = 0; step < steps; step++) {
+    std::vector<Actions> actions = puzzle.actions(state);
+    puzzle.apply(state, actions[rand() % actions.size()]);
+  }
+  return state;
+}
+
+TEST_CASE("Sliding tile puzzles keep h up to date") {
+  SlidingTile<4, 4> puzzle{
+    { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 0 },
+    { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 0 }
+  };
+
+  srand(5);
+  TileState<4, 4> state = puzzle.goal;
+  for (int step = 0; step < 500; step++) {
+    state = random_walk(puzzle, state, 1);
+    std::array<int, 16> board;
+    std::copy(state.tiles.begin(), state.tiles.end(), board.begin());
+    TileState<4, 4> fresh = puzzle.make_state(board);
+    REQUIRE(state.h == fresh.h);
+    REQUIRE(state.blank == fresh.blank);
+  }
+
+  TileState<4, 4> before = state;
+  puzzle.apply(state, puzzle.actions(state).front());
+  puzzle.undo(state, puzzle.actions(before).front());
+  REQUIRE(state == before);
+  REQUIRE(state.h == before.h);
+}
+
+TEST_CASE("Solvability holds for every board size") {
+  srand(9);
+
+  SECTION("3x3") {
+    SlidingTile<3, 3> puzzle{ { 1, 2, 3, 4, 5, 6, 7, 8, 0 }, { 1, 2, 3, 4, 5, 6, 7, 8, 0 } };
+    REQUIRE(puzzle.is_solvable(random_walk(puzzle, puzzle.goal, 101)));
+    REQUIRE(!puzzle.is_solvable(puzzle.make_state({ 1, 2, 3, 4, 6, 5, 7, 8, 0 })));
+  }
+
+  SECTION("4x4") {
+    SlidingTile<4, 4> puzzle{
+      { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 0 },
+      { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 0 }
+    };
+    for (int i = 0; i < 20; i++) {
+      REQUIRE(puzzle.is_solvable(random_walk(puzzle, puzzle.goal, 100 + i)));
+    }
+    REQUIRE(!puzzle.is_solvable(puzzle.make_state({ 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 15, 14, 0 })));
+    // No inversions, as in the goal, but the blank is one row off: the odd-width rule fails here.
+    REQUIRE(!puzzle.is_solvable(puzzle.make_state({ 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 0, 12, 13, 14, 15 })));
+  }
+
+  SECTION("3x4") {
+    SlidingTile<4, 3> puzzle{ { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 0 }, { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11 } };
+    REQUIRE(puzzle.is_solvable(random_walk(puzzle, puzzle.goal, 77)));
+    REQUIRE(!puzzle.is_solvable(puzzle.make_state({ 0, 2, 1, 3, 4, 5, 6, 7, 8, 9, 10, 11 })));
+  }
+}
+
+TEST_CASE("Sliding tile puzzles reject bad tiles") {
+  std::array<int, 9> goal = { 1, 2, 3, 4, 5, 6, 7, 8, 0 };
+  REQUIRE_THROWS_AS((SlidingTile<3, 3>{ { 1, 2, 3, 4, 5, 6, 7, 8, 9 }, goal }), std::invalid_argument);
+  REQUIRE_THROWS_AS((SlidingTile<3, 3>{ { 1, 2, 3, 4, 5, 6, 7, 8, -1 }, goal }), std::invalid_argument);
+  REQUIRE_THROWS_AS((SlidingTile<3, 3>{ { 1, 2, 3, 4, 5, 6, 7, 8, 8 }, goal }), std::invalid_argument);
+  REQUIRE_THROWS_AS((SlidingTile<3, 3>{ goal, { 1, 2, 3, 4, 5, 6, 7, 8, 8 } }), std::invalid_argument);
+}
+
+TEST_CASE("A* solves sliding tile puzzles") {
+  SECTION("hardest 8 Puzzle") {
+    SlidingTile<3, 3> puzzle{ { 8, 6, 7, 2, 5, 4, 3, 0, 1 }, { 1, 2, 3, 4, 5, 6, 7, 8, 0 } };
+    NodeArena<TileState<3, 3>, Actions> arena;
+
+    NodeIndex found = astar_search(puzzle, arena);
+    REQUIRE(found != no_node);
+    REQUIRE(arena[found].path_cost == Approx(31));
+  }
+
+  SECTION("15 Puzzle, with and without a pattern database") {
+    std::array<int, 16> goal = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 0 };
+    SlidingTile<4, 4> puzzle{ goal, goal };
+    srand(21);
+    puzzle.initial = random_walk(puzzle, puzzle.goal, 60);
+    NodeArena<TileState<4, 4>, Actions> arena;
+
+    NodeIndex manhattan = astar_search(puzzle, arena);
+    REQUIRE(manhattan != no_node);
+    double optimal = arena[manhattan].path_cost;
+    REQUIRE(optimal <= 60);
+
+    PatternDatabase database{
+      4, 4, std::vector<int>(goal.begin(), goal.end()),
+      { { 1, 2, 5, 6 }, { 3, 4, 7, 8 }, { 9, 10, 13, 14 }, { 11, 12, 15 } }
+    };
+    puzzle.pattern_database = &database;
+    NodeIndex pattern = astar_search(puzzle, arena);
+    REQUIRE(arena[pattern].path_cost == Approx(optimal));
+    REQUIRE(puzzle.is_goal(arena[pattern].state));
+  }
+
+  SECTION("24 Puzzle") {
+    std::array<int, 25> goal;
+    for (int i = 0; i < 25; i++) {
+      goal[i] = i;
+    }
+    SlidingTile<5, 5> puzzle{ goal, goal };
+    srand(4);
+    puzzle.initial = random_walk(puzzle, puzzle.goal, 30);
+    NodeArena<TileState<5, 5>, Actions> arena;
+
+    NodeIndex found = astar_search(puzzle, arena);
+    REQUIRE(found != no_node);
+    REQUIRE(arena[found].path_cost <= 30);
+    REQUIRE(arena.path_states(found).back() == puzzle.goal);
+  }
+}
@@ -0,0 +1,285 @@
+#pragma once
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// ---------------------------------------------------------------------------------
+// Run statistics
+
+/*
+ * Algorithms count what they do in the types below. Building with
+ * -DSEARCH_STATS=0 turns them into empty types whose operations do nothing (no
+ * counter is touched, no clock read), so the instrumented loops compile to the
+ * uninstrumented ones; every value then reads 0.
+ */
+#ifndef SEARCH_STATS
+#define SEARCH_STATS 1
+#endif
+
+constexpr bool stats_enabled = SEARCH_STATS != 0;
+
+#if SEARCH_STATS
+
+struct Counter {
+  Counter& operator++() {
+    count++;
+    return *this;
+  }
+
+  Counter& operator+=(uint64_t n) {
+    count += n;
+    return *this;
+  }
+
+  uint64_t value() const {
+    return count;
+  }
+
+private:
+  uint64_t count = 0;
+};
+
+/*
+ * Largest value recorded, e.g. the peak size of a container.
+ */
+struct Peak {
+  void record(uint64_t n) {
+    if (n > peak) {
+      peak = n;
+    }
+  }
+
+  uint64_t value() const {
+    return peak;
+  }
+
+private:
+  uint64_t peak = 0;
+};
+
+/*
+ * Seconds spent in each phase of a run, in the order the phases first ran.
+ */
+struct PhaseTimes {
+  void add(std::string_view phase, double seconds) {
+    for (auto& [name, total] : phases) {
+      if (name == phase) {
+        total += seconds;
+        return;
+      }
+    }
+    phases.emplace_back(phase, seconds);
+  }
+
+  double operator[](std::string_view phase) const {
+    for (const auto& [name, total] : phases) {
+      if (name == phase) {
+        return total;
+      }
+    }
+    return 0;
+  }
+
+  std::vector<std::pair<std::string_view, double>> phases;  // Names are literals.
+};
+
+/*
+ * Adds the time until it is destroyed to a phase.
+ */
+struct PhaseTimer {
+  PhaseTimer(PhaseTimes& times, std::string_view phase)
+  : times{ times }, phase{ phase }, start{ std::chrono::steady_clock::now() } {}
+
+  ~PhaseTimer() {
+    times.add(phase, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+  }
+
+private:
+  PhaseTimes& times;
+  std::string_view phase;
+  std::chrono::steady_clock::time_point start;
+};
+
+#else
+
+struct Counter {
+  Counter& operator++() { return *this; }
+  Counter& operator+=(uint64_t) { return *this; }
+  uint64_t value() const { return 0; }
+};
+
+struct Peak {
+  void record(uint64_t) {}
+  uint64_t value() const { return 0; }
+};
+
+struct PhaseTimes {
+  void add(std::string_view, double) {}
+  double operator[](std::string_view) const { return 0; }
+  std::vector<std::pair<std::string_view, double>> phases;
+};
+
+struct PhaseTimer {
+  PhaseTimer(PhaseTimes&, std::string_view) {}
+};
+
+#endif
+
+// ---------------------------------------------------------------------------------
+// JSON export
+
+/*
+ * Writes one JSON object to out, field by field; the closing brace is written
+ * when it is destroyed. Nested objects are opened on key(name):
+ *
+ *   JsonObject stats{ out };
+ *   stats.field("expanded", 12);
+ *   { JsonObject phases{ stats.key("phases") }; phases.field("search", 0.5); }
+ */
+struct JsonObject {
+  explicit JsonObject(std::ostream& out) : out{ out } {
+    out << '{';
+  }
+
+  ~JsonObject() {
+    out << '}';
+  }
+
+  JsonObject(const JsonObject&) = delete;
+  JsonObject& operator=(const JsonObject&) = delete;
+
+  /*
+   * Starts the field name, and returns the stream to write its value to.
+   */
+  std::ostream& key(std::string_view name) {
+    if (!first) {
+      out << ',';
+    }
+    first = false;
+    string(name);
+    return out << ':';
+  }
+
+  JsonObject& field(std::string_view name, uint64_t value) {
+    key(name) << value;
+    return *this;
+  }
+
+  JsonObject& field(std::string_view name, int value) {
+    key(name) << value;
+    return *this;
+  }
+
+  /*
+   * NaN and infinities, which JSON lacks, are written as null.
+   */
+  JsonObject& field(std::string_view name, double value) {
+    key(name);
+    if (std::isfinite(value)) {
+      out << value;
+    } else {
+      out << "null";
+    }
+    return *this;
+  }
+
+  JsonObject& field(std::string_view name, bool value) {
+    key(name) << (value ? "true" : "false");
+    return *this;
+  }
+
+  JsonObject& field(std::string_view name, std::string_view value) {
+    key(name);
+    string(value);
+    return *this;
+  }
+
+  JsonObject& field(std::string_view name, const char* value) {
+    return field(name, std::string_view{ value });
+  }
+
+  JsonObject& field(std::string_view name, const Counter& value) {
+    return field(name, value.value());
+  }
+
+  JsonObject& field(std::string_view name, const Peak& value) {
+    return field(name, value.value());
+  }
+
+  JsonObject& field(std::string_view name, const PhaseTimes& value) {
+    JsonObject phases{ key(name) };
+    for (const auto& [phase, seconds] : value.phases) {
+      phases.field(phase, seconds);
+    }
+    return *this;
+  }
+
+private:
+  void string(std::string_view text) {
+    out << '"';
+    for (char c : text) {
+      if (c == '"' || c == '\\') {
+        out << '\\' << c;
+      } else if (static_cast<unsigned char>(c) < 0x20) {
+        static constexpr char hex[] = "0123456789abcdef";
+        out << "\\u00" << hex[c >> 4] << hex[c & 0xF];
+      } else {
+        out << c;
+      }
+    }
+    out << '"';
+  }
+
+  std::ostream& out;
+  bool first = true;
+};
+
+/*
+ * The JSON of anything with a write_json(std::ostream&, const T&).
+ */
+template <typename T>
+std::string to_json(const T& stats) {
+  std::ostringstream out;
+  write_json(out, stats);
+  return out.str();
+}
+
+// ---------------------------------------------------------------------------------
+// Search statistics
+
+/*
+ * What a best-first search did. A node is expanded when its successors are
+ * generated; a generated state is a duplicate when it was reached before (and
+ * improved when that gave it a cheaper path). bytes is the memory held by the
+ * search context when the search ended.
+ */
+struct SearchStats {
+  Counter expanded;
+  Counter generated;
+  Counter duplicates;
+  Counter improved;
+  Peak frontier;
+  Peak reached;
+  Peak bytes;
+  PhaseTimes phases;
+};
+
+inline void write_json(std::ostream& out, const SearchStats& stats) {
+  JsonObject json{ out };
+  json.field("enabled", stats_enabled)
+    .field("expanded", stats.expanded)
+    .field("generated", stats.generated)
+    .field("duplicates", stats.duplicates)
+    .field("improved", stats.improved)
+    .field("peak_frontier", stats.frontier)
+    .field("peak_reached", stats.reached)
+    .field("bytes", stats.bytes)
+    .field("phases", stats.phases);
+}
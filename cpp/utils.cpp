@@ -1,3 +1,5 @@
+#pragma once
+
 #include <random>
 #include <cmath>
 #include <map>
@@ -9,17 +11,19 @@
 #include <utility>
 #include <iostream>
 
+#include "random.cpp"
+
 /*
  * Cleaner alias for duples.
  */
 using Index2D = std::pair<int, int>;
 
 template<typename S>
-S generateRandomIndividual(int size) {
+S generateRandomIndividual(int size, Random& random = thread_random()) {
   S individual;
   
   for(int i = 0; i < size; i++) {
-    int n = rand() % size;
+    int n = random.below(size);
     individual.push_back(n);
   }
 
@@ -27,10 +31,10 @@ S generateRandomIndividual(int size) {
 }
 
 template<typename S>
-std::vector<S> generateRandomPopulation(int populationSize, int individualSize) {
+std::vector<S> generateRandomPopulation(int populationSize, int individualSize, Random& random = thread_random()) {
   std::vector<S> population;
   for (int i = 0; i < populationSize; i++) {
-    S individual = generateRandomIndividual<S>(individualSize);
+    S individual = generateRandomIndividual<S>(individualSize, random);
     population.push_back(individual);
   }
   return population;
@@ -41,11 +45,8 @@ std::ostream& operator<<(std::ostream& os, const Index2D& value) {
   return os;
 }
 
-template <typename S>
-using Matrix = std::vector<std::vector<S>>;
-
 template <typename S, typename T>
-bool verifyTransform(Matrix<T> matrix, S vector) {
+bool verifyTransform(std::vector<std::vector<T>> matrix, S vector) {
   for(int i = 0; i < vector.size(); i++) {
     if(matrix[vector[i]-1][i] != 1) return false;
   }
@@ -64,23 +65,19 @@ void print_array(std::string msg, const std::vector<T>& array, int i = 0) {
 /*
  * Return true with probability p.
  */
-bool probability(double p) {
-  std::random_device rd{};
-  std::uniform_real_distribution<double> distribution{ 0.0, 1.0 };
-  return p > distribution(rd);
+inline bool probability(double p, Random& random = thread_random()) {
+  return random.chance(p);
 }
 
 /*
  * Picks a random element from a vector.
  */
 template <typename T>
-T random_choice(const std::vector<T>& vec) {
+T random_choice(const std::vector<T>& vec, Random& random = thread_random()) {
   if (vec.empty()) {
     throw std::out_of_range("Empty vector");
   }
-  std::random_device rd{};
-  std::uniform_int_distribution<size_t> distribution(0, vec.size() - 1);
-  return vec[distribution(rd)];
+  return vec[random.below(vec.size())];
 }
 
 
@@ -155,11 +152,11 @@ bool remove(Container& container, const T& element) {
 }
 
 template <typename S, typename A>
-double ucb(MCT_Node<S, A> n, double C = 1.4) {
+double ucb(const MCT_Node<S, A>& n, double C = 1.4) {
   if (n.N == 0) {
     return INFINITY;
   }
-  return n.U / n.N + C * std::sqrt(std::log(n.parent->N) / n.N);
+  return double(n.U) / n.N + C * std::sqrt(std::log(n.parent->N) / n.N);
 }
 
 /*